@@ -2,6 +2,7 @@
 #define __STRUCTS_H__
 
 #include <mpi.h>
+#include <stdint.h>
 #define ndims 2 
 
 typedef enum version_enum
@@ -11,10 +12,200 @@ typedef enum version_enum
 
 }version;
 
+typedef enum engine_enum
+{
+	int_engine,
+	fused_engine,
+	bit_engine,
+	simd_engine,
+	temporal_engine,
+	hash_engine,
+
+}engine;
+
+/* Random number generator used to initialise the landscape */
+typedef enum init_enum
+{
+	uni_init,
+	counter_init,
+
+}init;
+
+/* Format of the final cell.pbm image */
+typedef enum pbm_enum
+{
+	pbm_binary,
+	pbm_ascii,
+
+}pbm;
+
+/* Widest instruction set the SIMD engine may use */
+typedef enum isa_enum
+{
+	isa_auto,
+	isa_scalar,
+	isa_sse2,
+	isa_avx2,
+	isa_avx512,
+
+}isa;
+
+/* Cells summed by the rule, the cell itself included */
+typedef enum neighbourhood_enum
+{
+	von_neumann,            /* The cell and its four orthogonal neighbours, sums 0 to 5 */
+	moore,                  /* The cell and its eight neighbours, sums 0 to 9 */
+
+}neighbourhood;
+
+/* Halo exchange of par_process (-exchange) */
+typedef enum exchange_enum
+{
+	persistent_exchange,    /* Persistent sends and receives started every step */
+	message_exchange,       /* Non-blocking sends and receives posted every step */
+	shared_exchange,        /* Edges of the neighbours on the node read from shared memory, messages across nodes */
+	rma_exchange,           /* Edges put into the halos of the neighbours, in PSCW epochs among them */
+	neighbour_exchange,     /* One neighbourhood collective on the Cartesian communicator */
+
+}exchange;
+
+/* Phases of the steps of par_process timed by -profile */
+typedef enum phase_enum
+{
+	post_phase,             /* Posting the halo sends and receives */
+	wait_phase,             /* Waiting for the halo exchange to complete */
+	adjust_phase,           /* Masking the top and bottom boundaries */
+	count_phase,            /* Counting the neighbours, int engine only */
+	update_phase,           /* Updating the cells, which the fused engine does while counting */
+	reduce_phase,           /* Reducing and reporting the live cells */
+	nphases,
+
+}phase;
+
+/* Binary image being written with non-blocking MPI-IO */
+typedef struct image_struct
+{
+	MPI_File fh;
+	MPI_Request request;
+	MPI_Datatype type;      /* Block of the image written by this process */
+	unsigned char *block;   /* Packed copy of the tile, kept until the write completes */
+	int pending;
+
+} image_str;
+
+/* In-run snapshots */
+typedef struct snapshot_struct
+{
+	image_str image;
+	int count;
+	double time;            /* Time the step loop spent starting and completing snapshots */
+
+} snapshot_str;
+
+/* Outer-totalistic rule: the next state of a cell depends only on the sum over its neighbourhood.
+   The kernels compare the sum against the smaller of the sets of live and dead sums */
+#define RULE_SUMS 10
+#define RULE_MEMBERS 5
+typedef struct rule_struct
+{
+	neighbourhood neighbourhood;
+	unsigned char alive[RULE_SUMS]; /* Next state for each neighbourhood sum */
+	int count;              /* Sums compared against, at most RULE_MEMBERS */
+	int members[RULE_MEMBERS]; /* The sums compared against, -1 when unused */
+	int invert;             /* The members are the sums that leave the cell dead */
+
+} rule_str;
+
+/* Header at the start of a checkpoint file, followed at CHECKPOINT_OFFSET by one byte per cell
+   of the whole landscape in row-major order */
+#define CHECKPOINT_MAGIC 0x4b434143  /* "CACK" */
+#define CHECKPOINT_OFFSET 64
+typedef struct checkpoint_struct
+{
+	int magic;
+	int landscape;
+	int step;               /* Last step completed */
+	int initialcells;
+	int seed;
+	double rho;
+	neighbourhood neighbourhood; /* Rule the landscape evolves under, which a restart must use too */
+	unsigned char alive[RULE_SUMS];
+
+} checkpoint_str;
+
+/* Replicas of an ensemble, one per bit of a word */
+#define MAXREPLICAS 64
+
+/* Change tracking of the fused engine over square blocks of the tile (-active) */
+#define ACTIVE_BLOCK 8
+typedef struct active_struct
+{
+	int brows, bcols;       /* Blocks down and across the tile */
+	unsigned char *changed; /* Block differs from two steps back */
+	unsigned char *dirty;   /* Block or a cell it reads may have changed, so it is computed */
+	int first;              /* The first step, on which no earlier generation is known */
+	int live_cells;         /* Live cells of the tile in the current generation */
+	int live_previous;      /* Live cells of the tile in the generation before */
+	double visited;         /* Blocks visited since the last report */
+	double computed;        /* Blocks computed since the last report */
+	double messages;        /* Halo messages to neighbours since the last report */
+	double skipped;         /* Halo messages sent empty since the last report */
+	int last_report;        /* Step of the last report */
+
+} active_str;
+
+/* Node of the quadtree of the hash engine: a leaf of 8 x 8 cells at level 3, otherwise a square of
+   2^level cells on a side made of four quadrants one level down. Nodes are hash-consed, so equal
+   squares are the same node and the evolution of each is computed once */
+typedef struct hash_node_struct
+{
+	union
+	{
+		struct hash_node_struct *child[4]; /* North-west, north-east, south-west and south-east quadrants */
+		uint64_t bits[4];   /* Live cells, cut seam cells above and below and walls of a leaf, row by row */
+	} square;
+	struct hash_node_struct *result;   /* Centre half advanced 2^(level-2) steps, NULL until computed */
+	struct hash_node_struct *chain;    /* Next node in the same bucket of the node table */
+	int level;
+
+} hash_node;
+
+/* Centre of a node advanced 2^jump steps, fewer than the 2^(level-2) of its result */
+typedef struct hash_memo_struct
+{
+	hash_node *node;
+	hash_node *result;
+	int jump;
+
+} hash_memo;
+
+/* Hash-consed quadtree and memoised results of the hash engine */
+typedef struct hash_struct
+{
+	hash_node **buckets;    /* Node table, chained */
+	size_t nbuckets;
+	size_t nodes;
+	hash_node **chunks;     /* Blocks the nodes are allocated from */
+	int nchunks, maxchunks;
+	int chunk_used;         /* Nodes taken from the last block */
+	hash_memo *memo;        /* Open-addressed table of the shorter jumps */
+	size_t nmemo, memo_used;
+	hash_node **empty;      /* Dead square of each level */
+	uint32_t states[6];     /* Next state of a row of cells for each neighbourhood sum, all ones or zeros */
+	int level;              /* Level of the universe, which holds three copies of the landscape */
+	int band_start, band_end; /* Columns of the periodic boundary band */
+	int jumps;              /* Jumps taken */
+	int longest;            /* Steps of the longest jump */
+	int clears;             /* Times the tables were emptied to bound their memory */
+
+} hash_str;
+
 typedef struct dimensions_struct
 {
 	int rows;
 	int cols;
+	int first_row;          /* Global index of the first row of the tile */
+	int first_col;          /* Global index of the first column of the tile */
 
 } dim_str;
 
@@ -41,6 +232,7 @@ typedef struct cartesian_struct
 	int period[ndims];
 	int coords[ndims];
 	int reorder;
+	int node_dims[ndims];   /* Block of the process grid on each node, 0 x 0 unless placed by node */
 	dir_str right, left, down, up;
 
 } cart_str;
@@ -53,12 +245,46 @@ typedef struct communication_struct
 
 } comm_str;
 
+/* Halo exchange of par_process, set up once before the steps */
+typedef struct halo_struct
+{
+	exchange exchange;
+	MPI_Datatype row_type, column_type;
+	cart_str remote;        /* Topology with the neighbours reached by messages, MPI_PROC_NULL for the others */
+	MPI_Request reqs[16];   /* Halo messages, then notifications between neighbours on the node */
+	MPI_Request persistent[2][8]; /* Halo sends and receives of each grid, created once and started every step */
+	MPI_Comm graph_comm;    /* The distinct neighbours of the grid, for the neighbourhood collective */
+	int nneighbours;
+	MPI_Datatype send_types[2][4]; /* Edges of each grid sent to each distinct neighbour */
+	MPI_Datatype recv_types[2][4]; /* Halos of each grid received from it */
+	int **grids[2];         /* The grids of the steps, which the fused engine swaps */
+	int **saved[2];         /* Grids of the caller, which the shared grids stand in for */
+	MPI_Comm node_comm;     /* Processes on the node */
+	MPI_Win win;            /* Shared grids of the node */
+	int peer[4];            /* Neighbour up, down, left and right on the node, MPI_PROC_NULL if none */
+	int *edges[4][2];       /* First cell of the edge each of them shares, in each of its grids */
+	int width[4];           /* Padded row length of their grids */
+	int links;              /* Neighbours on the node */
+	MPI_Win grid_wins[2];   /* Windows on the grids of the steps, which the neighbours put their edges into */
+	MPI_Group group;        /* The neighbours, which access and expose the windows */
+	MPI_Datatype target_types[4]; /* Halo of the neighbour up, down, left and right that an edge is put into */
+	MPI_Aint target_disps[4];
+
+} halo_str;
+
 
 typedef struct time_struct
 {
 	double start;
 	double local;
 	double average;
+	double halo;            /* Time blocked in halo exchanges, accumulated over the steps */
+	double step;            /* Time spent in the exchange and computation of the steps */
+	double reduce;          /* Time spent reducing the live cells on the print steps */
+	double halo_average;
+	double step_average;
+	double gather;          /* Time spent collecting the final landscape on the root */
+	double write;           /* Time spent writing the final landscape */
 
 }time_str;
 
@@ -68,14 +294,42 @@ typedef struct parameters
 {
 	  int seed;
       double rho;
+	  rule_str rule;
 	  int printfreq;
 	  int landscape;
 	  int maxstep;
 	  double r;
 	  version version;
+	  engine engine;
+	  isa isa;
+	  int overlap;
+	  int active;             /* Skip blocks that cannot have changed */
+	  int halo;
+	  init init;
+	  pbm pbm;
+	  int snapfreq;
+	  int checkpointfreq;
+	  int threads;            /* OpenMP threads per process, 0 for the OpenMP default */
+	  char *restart;          /* Checkpoint file to resume from, NULL for a new run */
+	  int profile;            /* Time the phases of the steps on every rank */
+	  int reorder;            /* Choose the process grid and place the ranks by node */
+	  exchange exchange;
+	  int ensemble;           /* Independent replicas advanced together, 0 for a single landscape */
+	  int seedstep;           /* Seed increment from one replica to the next */
+	  double rhostep;         /* Density increment from one replica to the next */
+	  int bench;              /* Timed benchmark trials, 0 for a normal run */
+	  char *benchfile;        /* CSV or, with a .json name, JSON lines file the trials are appended to */
 } params_str;
 
 
+/* Time accumulated in each phase of the steps with -profile */
+typedef struct profile_struct
+{
+	double time[nphases];
+	double mark;            /* End of the last phase timed */
+
+} profile_str;
+
 typedef struct master {
 
     params_str params;
@@ -83,8 +337,11 @@ typedef struct master {
     cart_str cart;
     dim_str dimensions;
     int initialcells;
+    int start_step;         /* Step the run resumes from, 0 for a new run */
     int version;
 	time_str time;
+	snapshot_str snapshot;
+	profile_str profile;
 } master_str;
 
 
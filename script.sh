@@ -1,53 +1,43 @@
 #!/bin/bash
-# run_scaling.sh
-# This script performs weak and strong scaling tests for Conway's Game of Life automaton.
-# It runs each configuration 10 times and captures only the timing data (using the time command).
-# The automaton’s own output is discarded.
-
-OUTPUT_FILE="timing_results.txt"
-SEED=42  # Fixed seed for all runs
-
-# Remove any existing output file.
-rm -f "$OUTPUT_FILE"
-
-# Write a minimal header.
-echo "Timing results for Conway's Game of Life scaling tests" > "$OUTPUT_FILE"
-echo "Start Time: $(date)" >> "$OUTPUT_FILE"
-echo "" >> "$OUTPUT_FILE"
+# script.sh
+# This script performs weak and strong scaling tests for the cellular automaton.
+# Each configuration runs in the -bench mode of the automaton, which times a warmup trial and
+# TRIALS timed trials itself and appends the median, minimum and standard deviation of every
+# phase (init, loop, halo, compute, reduction, output) to a CSV file, so MPI startup is not timed.
+# The automaton's own output is discarded.
+
+WEAK_FILE="bench_weak.csv"
+STRONG_FILE="bench_strong.csv"
+SEED=42                          # Fixed seed for all runs
+STEPS=${STEPS:-500}              # Steps per trial
+TRIALS=${TRIALS:-5}              # Timed trials per configuration
+ENGINE=${ENGINE:-fused}          # Engine to benchmark
+
+# Remove any existing results.
+rm -f "$WEAK_FILE" "$STRONG_FILE"
+
+# Run one configuration: number of processes, landscape size and results file.
+bench() {
+    mpirun -n "$1" ./automaton "$SEED" -landscape "$2" -maxstep "$STEPS" -printfreq "$STEPS" \
+        -engine "$ENGINE" -bench "$TRIALS" -benchfile "$3" > /dev/null
+}
 
 #################################
 # Weak Scaling Experiment
 #################################
-echo "Weak Scaling Test: Fixed 5 processors, varying landscape sizes" >> "$OUTPUT_FILE"
-# List of landscape sizes.
+# Fixed 5 processors, varying landscape sizes.
 landscapes=(500 1000 1500 2000 2500 3000 3500 4000 4500 5000)
 
 for LAND in "${landscapes[@]}"; do
-    echo "Landscape Size: $LAND" >> "$OUTPUT_FILE"
-    for run in {1..10}; do
-        echo "  Run #$run:" >> "$OUTPUT_FILE"
-        # Run the program with 5 processors, discard its output, and capture the timing data.
-        { time mpirun -n 5 ./automaton "$SEED" -landscape "$LAND" > /dev/null; } 2>> "$OUTPUT_FILE"
-        echo "  ------------------------------------" >> "$OUTPUT_FILE"
-    done
-    echo "" >> "$OUTPUT_FILE"
+    bench 5 "$LAND" "$WEAK_FILE"
 done
 
 #################################
 # Strong Scaling Experiment
 #################################
-echo "Strong Scaling Test: Fixed landscape size (5000), varying processors" >> "$OUTPUT_FILE"
-# List of processor counts.
+# Fixed landscape size (5000), varying processors.
 procs=(2 4 6 8 10 12 14 16)
 
 for NP in "${procs[@]}"; do
-    echo "Processor Count: $NP" >> "$OUTPUT_FILE"
-    for run in {1..10}; do
-        echo "  Run #$run:" >> "$OUTPUT_FILE"
-        { time mpirun -n "$NP" ./automaton "$SEED" -landscape 5000 > /dev/null; } 2>> "$OUTPUT_FILE"
-        echo "  ------------------------------------" >> "$OUTPUT_FILE"
-    done
-    echo "" >> "$OUTPUT_FILE"
+    bench "$NP" 5000 "$STRONG_FILE"
 done
-
-echo "End Time: $(date)" >> "$OUTPUT_FILE"
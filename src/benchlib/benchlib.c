@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <mpi.h>
+#include "structs.h"
+#include "benchlib.h"
+#include "wraplib.h"
+#include "mplib.h"
+
+// Phases timed in every trial. The loop phase is the whole step loop, of which the compute phase is
+// the part not spent exchanging halos or reducing the live cells.
+#define NPHASES 6
+#define INIT_PHASE 0
+#define LOOP_PHASE 1
+#define HALO_PHASE 2
+#define COMPUTE_PHASE 3
+#define REDUCTION_PHASE 4
+#define OUTPUT_PHASE 5
+
+static const char *phase_names[NPHASES] = {"init", "loop", "halo", "compute", "reduction", "output"};
+
+// Names of the engines in the order of the engine enum
+static const char *engine_names[] = {"int", "fused", "bit", "simd", "temporal", "hash"};
+
+// Compare two doubles for qsort.
+static int compare_doubles(const void *a, const void *b) {
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+// Compute the median, minimum and sample standard deviation of n values.
+static void compute_stats(const double *values, int n, double stats[3]) {
+    double sorted[n];
+    double mean = 0.0;
+    double variance = 0.0;
+
+    memcpy(sorted, values, n * sizeof(double));
+    qsort(sorted, n, sizeof(double), compare_doubles);
+    for (int i = 0; i < n; i++) {
+        mean += values[i] / n;
+    }
+    for (int i = 0; i < n && n > 1; i++) {
+        variance += (values[i] - mean) * (values[i] - mean) / (n - 1);
+    }
+    stats[0] = (n % 2) ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+    stats[1] = sorted[0];
+    stats[2] = sqrt(variance);
+}
+
+// Run the whole program once: initialisation, step loop and output. Each phase takes the time of the
+// slowest rank, which holds up the others.
+static void run_trial(master_str *master, int ***cell_grid, int ***neighbor_grid, int **global_cell_grid, int **local_cell_grid, double times[NPHASES]) {
+    double local_times[NPHASES];
+    double start;
+
+    MPI_Barrier(master->cart.comm2d);
+    start = gettime();
+    initialise_and_distribute(master, *cell_grid, global_cell_grid, local_cell_grid);
+    local_times[INIT_PHASE] = gettime() - start;
+
+    MPI_Barrier(master->cart.comm2d);
+    start = gettime();
+    process(master, cell_grid, neighbor_grid);
+    local_times[LOOP_PHASE] = gettime() - start;
+    local_times[HALO_PHASE] = master->time.halo;
+    local_times[REDUCTION_PHASE] = master->time.reduce;
+    local_times[COMPUTE_PHASE] = local_times[LOOP_PHASE] - master->time.halo - master->time.reduce;
+
+    MPI_Barrier(master->cart.comm2d);
+    start = gettime();
+    gather_write_data(master, local_cell_grid, global_cell_grid, *cell_grid);
+    local_times[OUTPUT_PHASE] = gettime() - start;
+
+    for (int p = 0; p < NPHASES; p++) {
+        times[p] = mpgmax(master->cart, &local_times[p]);
+    }
+}
+
+// Compute the statistics of the time of one phase over the trials and, for the phases of the step
+// loop, of the steps and cell updates per second that the time of the phase alone would allow.
+// Rates are left out (zero) when the phase took no time on some trial, as the halo exchange of a single process.
+// values is scratch space for one value per trial.
+static int phase_stats(double times[][NPHASES], int trials, int phase, int steps, double cells, double *values, double stats[9]) {
+    int rated = (phase != INIT_PHASE && phase != OUTPUT_PHASE);
+
+    for (int t = 0; t < trials; t++) {
+        values[t] = times[t][phase];
+        rated = rated && values[t] > 0.0;
+    }
+    compute_stats(values, trials, &stats[0]);
+    memset(&stats[3], 0, 6 * sizeof(double));
+    if (!rated) {
+        return 0;
+    }
+    for (int t = 0; t < trials; t++) {
+        values[t] = steps / times[t][phase];
+    }
+    compute_stats(values, trials, &stats[3]);
+    for (int t = 0; t < trials; t++) {
+        values[t] *= cells;
+    }
+    compute_stats(values, trials, &stats[6]);
+    return 1;
+}
+
+// Append the statistics of every phase to the results file, one CSV row per phase or, for a file
+// ending in .json, one JSON object per run.
+static void write_results(master_str *master, double times[][NPHASES], int trials, int steps) {
+    char *file = master->params.benchfile;
+    size_t length = strlen(file);
+    int json = (length >= 5 && strcmp(file + length - 5, ".json") == 0);
+    double cells = (double) master->params.landscape * master->params.landscape;
+    double stats[9];
+    double values[trials];
+
+    FILE *fp = fopen(file, "a");
+    if (fp == NULL) {
+        printf("automaton: could not open %s, benchmark results not written\n", file);
+        return;
+    }
+
+    if (json) {
+        fprintf(fp, "{\"engine\": \"%s\", \"processes\": %d, \"threads\": %d, \"landscape\": %d, \"steps\": %d, \"trials\": %d, \"phases\": {",
+                engine_names[master->params.engine], master->comm.size, master->params.threads, master->params.landscape, steps, trials);
+        for (int p = 0; p < NPHASES; p++) {
+            int rated = phase_stats(times, trials, p, steps, cells, values, stats);
+            fprintf(fp, "%s\"%s\": {\"median_s\": %g, \"min_s\": %g, \"stddev_s\": %g", p ? ", " : "", phase_names[p], stats[0], stats[1], stats[2]);
+            if (rated) {
+                fprintf(fp, ", \"median_steps_per_s\": %g, \"min_steps_per_s\": %g, \"stddev_steps_per_s\": %g"
+                            ", \"median_cell_updates_per_s\": %g, \"min_cell_updates_per_s\": %g, \"stddev_cell_updates_per_s\": %g",
+                        stats[3], stats[4], stats[5], stats[6], stats[7], stats[8]);
+            }
+            fprintf(fp, "}");
+        }
+        fprintf(fp, "}}\n");
+    } else {
+        // A new file starts with the header
+        fseek(fp, 0, SEEK_END);
+        if (ftell(fp) == 0) {
+            fprintf(fp, "engine,processes,threads,landscape,steps,trials,phase,median_s,min_s,stddev_s,"
+                        "median_steps_per_s,min_steps_per_s,stddev_steps_per_s,"
+                        "median_cell_updates_per_s,min_cell_updates_per_s,stddev_cell_updates_per_s\n");
+        }
+        for (int p = 0; p < NPHASES; p++) {
+            int rated = phase_stats(times, trials, p, steps, cells, values, stats);
+            fprintf(fp, "%s,%d,%d,%d,%d,%d,%s,%g,%g,%g", engine_names[master->params.engine], master->comm.size, master->params.threads,
+                    master->params.landscape, steps, trials, phase_names[p], stats[0], stats[1], stats[2]);
+            if (rated) {
+                fprintf(fp, ",%g,%g,%g,%g,%g,%g\n", stats[3], stats[4], stats[5], stats[6], stats[7], stats[8]);
+            } else {
+                fprintf(fp, ",,,,,,\n");
+            }
+        }
+    }
+    fclose(fp);
+}
+
+// Run a warmup trial, which is discarded, and params.bench timed trials of the whole run. The live
+// cells are not checked against the termination thresholds, so every trial runs the same steps.
+void benchmark(master_str *master, int ***cell_grid, int ***neighbor_grid, int **global_cell_grid, int **local_cell_grid) {
+    int trials = master->params.bench;
+    int steps = master->params.maxstep - master->start_step;
+    double times[trials][NPHASES];
+    double warmup[NPHASES];
+
+    run_trial(master, cell_grid, neighbor_grid, global_cell_grid, local_cell_grid, warmup);
+    report_memory(master);
+    for (int t = 0; t < trials; t++) {
+        run_trial(master, cell_grid, neighbor_grid, global_cell_grid, local_cell_grid, times[t]);
+    }
+
+    if (master->comm.rank == 0) {
+        double loop[3];
+        double values[trials];
+        for (int t = 0; t < trials; t++) {
+            values[t] = times[t][LOOP_PHASE];
+        }
+        compute_stats(values, trials, loop);
+        printf("automaton: benchmark of %d trials, median loop %f s, %.1f steps/s, %.4g cell updates/s, results appended to %s\n",
+               trials, loop[0], steps / loop[0], steps / loop[0] * master->params.landscape * master->params.landscape, master->params.benchfile);
+        write_results(master, times, trials, steps);
+    }
+}
@@ -0,0 +1,9 @@
+#ifndef __BENCHLIB_H__
+#define __BENCHLIB_H__
+
+#include "structs.h"
+
+// Runs a warmup trial and params.bench timed trials of the whole run and appends the statistics of each phase to params.benchfile
+void benchmark(master_str *master, int ***cell_grid, int ***neighbor_grid, int **global_cell_grid, int **local_cell_grid);
+
+#endif // __BENCHLIB_H__
@@ -0,0 +1,334 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "structs.h"
+#include "bitlib.h"
+#include "misc.h"
+
+// Returns the word holding the given padded column and the position of the column inside it.
+#define WORD(col) ((col) / CELLBITS)
+#define BIT(col) ((uint64_t) 1 << ((col) % CELLBITS))
+
+// Pack the padded cell grid, halos included, so that column j of a row is bit j of the row.
+void pack_cells(int **cell_grid, uint64_t **packed_grid, master_str *master) {
+    int nwords = PACKED_WORDS(master->dimensions.cols);
+    for (int i = 0; i <= master->dimensions.rows + 1; i++) {
+        memset(packed_grid[i], 0, nwords * sizeof(uint64_t));
+        for (int j = 0; j <= master->dimensions.cols + 1; j++) {
+            if (cell_grid[i][j]) {
+                packed_grid[i][WORD(j)] |= BIT(j);
+            }
+        }
+    }
+}
+
+// Unpack the interior cells of the packed grid back into the padded int cell grid.
+void unpack_cells(uint64_t **packed_grid, int **cell_grid, master_str *master) {
+    for (int i = 1; i <= master->dimensions.rows; i++) {
+        for (int j = 1; j <= master->dimensions.cols; j++) {
+            cell_grid[i][j] = (packed_grid[i][WORD(j)] & BIT(j)) ? 1 : 0;
+        }
+    }
+}
+
+// Set the bits of the interior columns 1..cols, leaving the halo columns and the unused tail bits clear.
+void build_interior_mask(uint64_t *interior_mask, master_str *master) {
+    memset(interior_mask, 0, PACKED_WORDS(master->dimensions.cols) * sizeof(uint64_t));
+    for (int j = 1; j <= master->dimensions.cols; j++) {
+        interior_mask[WORD(j)] |= BIT(j);
+    }
+}
+
+// Set the bits of the columns whose global index lies inside the periodic boundary band.
+void build_boundary_mask(uint64_t *boundary_mask, int periodic_boundary_start, int periodic_boundary_end, master_str *master) {
+    memset(boundary_mask, 0, PACKED_WORDS(master->dimensions.cols) * sizeof(uint64_t));
+    for (int j = 1; j <= master->dimensions.cols; j++) {
+        int index = master->dimensions.first_col + j;
+        if (index >= periodic_boundary_start && index <= periodic_boundary_end) {
+            boundary_mask[WORD(j)] |= BIT(j);
+        }
+    }
+}
+
+// Copy the opposite edge rows into the top and bottom halos, keeping only the periodic band.
+void packed_periodic_boundary(uint64_t **packed_grid, uint64_t *boundary_mask, master_str *master) {
+    int nwords = PACKED_WORDS(master->dimensions.cols);
+    int rows = master->dimensions.rows;
+    for (int w = 0; w < nwords; w++) {
+        packed_grid[0][w] = packed_grid[rows][w] & boundary_mask[w];
+        packed_grid[rows + 1][w] = packed_grid[1][w] & boundary_mask[w];
+    }
+}
+
+// Clear the received top and bottom halo cells outside the periodic band on the edge processes.
+void packed_adjust_boundaries(uint64_t **packed_grid, uint64_t *boundary_mask, cart_str cart, master_str *master) {
+    int nwords = PACKED_WORDS(master->dimensions.cols);
+    if (cart.coords[0] == 0) {
+        for (int w = 0; w < nwords; w++) {
+            packed_grid[0][w] &= boundary_mask[w];
+        }
+    }
+    if (cart.coords[0] == cart.dims[0] - 1) {
+        for (int w = 0; w < nwords; w++) {
+            packed_grid[master->dimensions.rows + 1][w] &= boundary_mask[w];
+        }
+    }
+}
+
+// Next state of 64 cells for each neighbourhood sum 0..5 of the built-in rule: alive for 2, 4 and 5.
+static const uint64_t builtin_states[6] = {0, 0, ~(uint64_t) 0, 0, ~(uint64_t) 0, ~(uint64_t) 0};
+
+// Evaluate the 5-point rule for 64 cells at once. The five inputs are summed with bit-sliced
+// full adders into the binary digits s2 s1 s0, which select the next state out of states, all ones
+// or all zeros for each sum, through a tree of multiplexers. Sums 6 and 7 cannot occur, so s2 only
+// chooses between sums 4 and 5 and the sums below. With constant states the tree folds away: for
+// the built-in rule it is s2 | (s1 & ~s0).
+static inline uint64_t next_state(uint64_t up, uint64_t centre, uint64_t down, uint64_t left, uint64_t right, const uint64_t states[6]) {
+    uint64_t sum_a = up ^ centre ^ down;
+    uint64_t carry_a = (up & centre) | (down & (up ^ centre));
+    uint64_t sum_b = left ^ right;
+    uint64_t carry_b = left & right;
+
+    uint64_t s0 = sum_a ^ sum_b;
+    uint64_t carry_c = sum_a & sum_b;
+
+    uint64_t s1 = carry_a ^ carry_b ^ carry_c;
+    uint64_t s2 = (carry_a & carry_b) | (carry_c & (carry_a ^ carry_b));
+
+    uint64_t below_two = states[0] ^ (s0 & (states[0] ^ states[1]));
+    uint64_t two_three = states[2] ^ (s0 & (states[2] ^ states[3]));
+    uint64_t four_five = states[4] ^ (s0 & (states[4] ^ states[5]));
+    uint64_t below_four = below_two ^ (s1 & (below_two ^ two_three));
+    return below_four ^ (s2 & (below_four ^ four_five));
+}
+
+// Compute the next generation of rows 1..rows into next_grid for the given states of the sums and
+// count the live cells. The states are copied so that the stores to next_grid cannot alias them and
+// they stay in registers.
+static inline int packed_update_rows(uint64_t **packed_grid, uint64_t **next_grid, uint64_t *interior_mask, const uint64_t sum_states[6], master_str *master) {
+    int nwords = PACKED_WORDS(master->dimensions.cols);
+    int live_cells = 0;
+    uint64_t states[6];
+
+    memcpy(states, sum_states, sizeof(states));
+
+    #pragma omp parallel for schedule(static) reduction(+:live_cells)
+    for (int i = 1; i <= master->dimensions.rows; i++) {
+        uint64_t *up = packed_grid[i - 1];
+        uint64_t *row = packed_grid[i];
+        uint64_t *down = packed_grid[i + 1];
+        uint64_t *next = next_grid[i];
+
+        for (int w = 0; w < nwords; w++) {
+            uint64_t previous = (w > 0) ? row[w - 1] : 0;
+            uint64_t following = (w < nwords - 1) ? row[w + 1] : 0;
+
+            // Bit j of left holds column j-1 and bit j of right holds column j+1.
+            uint64_t left = (row[w] << 1) | (previous >> (CELLBITS - 1));
+            uint64_t right = (row[w] >> 1) | (following << (CELLBITS - 1));
+
+            next[w] = next_state(up[w], row[w], down[w], left, right, states) & interior_mask[w];
+            live_cells += __builtin_popcountll(next[w]);
+        }
+    }
+
+    return live_cells;
+}
+
+// Fill the states of the sums from the rule and return whether it is the built-in rule.
+static int rule_states(const rule_str *rule, uint64_t states[6]) {
+    int builtin = 1;
+    for (int s = 0; s < 6; s++) {
+        states[s] = rule->alive[s] ? ~(uint64_t) 0 : 0;
+        builtin = builtin && states[s] == builtin_states[s];
+    }
+    return builtin;
+}
+
+// Compute the next generation of every interior cell into next_grid and count the live cells. The
+// built-in rule runs the instance specialised on its constant states.
+void packed_update_cells(uint64_t **packed_grid, uint64_t **next_grid, uint64_t *interior_mask, int *local_live_cells, master_str *master) {
+    uint64_t states[6];
+
+    if (rule_states(&master->params.rule, states)) {
+        *local_live_cells = packed_update_rows(packed_grid, next_grid, interior_mask, builtin_states, master);
+    } else {
+        *local_live_cells = packed_update_rows(packed_grid, next_grid, interior_mask, states, master);
+    }
+}
+
+// Gather the first and last interior columns into bit-packed buffers, one bit per row.
+void pack_halo_columns(uint64_t **packed_grid, uint64_t *left_column, uint64_t *right_column, master_str *master) {
+    int ncolumnwords = PACKED_COLUMN_WORDS(master->dimensions.rows);
+    int cols = master->dimensions.cols;
+
+    memset(left_column, 0, ncolumnwords * sizeof(uint64_t));
+    memset(right_column, 0, ncolumnwords * sizeof(uint64_t));
+
+    for (int i = 1; i <= master->dimensions.rows; i++) {
+        if (packed_grid[i][WORD(1)] & BIT(1)) {
+            left_column[WORD(i - 1)] |= BIT(i - 1);
+        }
+        if (packed_grid[i][WORD(cols)] & BIT(cols)) {
+            right_column[WORD(i - 1)] |= BIT(i - 1);
+        }
+    }
+}
+
+// Scatter a bit-packed column buffer into halo column col (0 or cols+1) of the packed grid.
+void unpack_halo_column(uint64_t **packed_grid, uint64_t *column, int col, master_str *master) {
+    for (int i = 1; i <= master->dimensions.rows; i++) {
+        if (column[WORD(i - 1)] & BIT(i - 1)) {
+            packed_grid[i][WORD(col)] |= BIT(col);
+        } else {
+            packed_grid[i][WORD(col)] &= ~BIT(col);
+        }
+    }
+}
+
+// Initialise replica k of the ensemble, bit k of every cell word, with the generator of -init from
+// seed + k * seedstep and rho + k * rhostep, so that each replica starts from the landscape of a
+// single run with that seed and density. The live cells of each replica are stored in live_cells.
+void initialize_ensemble_cells(uint64_t **ensemble_grid, int *live_cells, master_str *master) {
+    int landscape = master->params.landscape;
+
+    for (int i = 1; i <= landscape; i++) {
+        memset(ensemble_grid[i], 0, (landscape + 2) * sizeof(uint64_t));
+    }
+    for (int k = 0; k < master->params.ensemble; k++) {
+        int seed = master->params.seed + k * master->params.seedstep;
+        double rho = master->params.rho + k * master->params.rhostep;
+        uint64_t bit = (uint64_t) 1 << k;
+
+        live_cells[k] = 0;
+        if (master->params.init == uni_init) {
+            rinit(seed);
+        }
+        for (int i = 0; i < landscape; i++) {
+            for (int j = 0; j < landscape; j++) {
+                double r = (master->params.init == uni_init) ? uni() : counter_uni(seed, i, j);
+                if (r < rho) {
+                    ensemble_grid[i + 1][j + 1] |= bit;
+                    live_cells[k]++;
+                }
+            }
+        }
+    }
+}
+
+// Copy the opposite edge rows into the top and bottom halos of every replica, keeping only the
+// columns inside the periodic band.
+void ensemble_periodic_boundary(uint64_t **ensemble_grid, int periodic_boundary_start, int periodic_boundary_end, master_str *master) {
+    int landscape = master->params.landscape;
+    for (int j = 1; j <= landscape; j++) {
+        uint64_t band = (j >= periodic_boundary_start && j <= periodic_boundary_end) ? ~(uint64_t) 0 : 0;
+        ensemble_grid[0][j] = ensemble_grid[landscape][j] & band;
+        ensemble_grid[landscape + 1][j] = ensemble_grid[1][j] & band;
+    }
+}
+
+// Carry-save adder of three words, bit by bit: the sum bits go into low and the carries into high.
+static inline void carry_save(uint64_t *high, uint64_t *low, uint64_t a, uint64_t b, uint64_t c) {
+    uint64_t u = a ^ b;
+    *high = (a & b) | (u & c);
+    *low = u ^ c;
+}
+
+// Add weight times each bit of word to the count of its replica.
+static void add_lanes(uint64_t word, int weight, int *live_cells, int replicas) {
+    for (int k = 0; k < replicas; k++) {
+        live_cells[k] += (int) ((word >> k) & 1) * weight;
+    }
+}
+
+// Add bit k of n words to the live cells of replica k, for every replica. Carry-save adders reduce
+// eight words at a time into the running ones, twos and fours of each bit, and the carry of weight
+// eight is added into bit-sliced counters, plane p holding bit p of the counts of eights. The
+// counters are added to the totals before they can overflow and at the end of the row.
+static void count_lanes(const uint64_t *words, int n, int *live_cells, int replicas) {
+    uint64_t ones = 0, twos = 0, fours = 0;
+    uint64_t planes[COUNT_PLANES] = {0};
+    int groups = 0;
+    int j = 0;
+
+    for (; j + 8 <= n; j += 8) {
+        uint64_t twos_a, twos_b, fours_a, fours_b, eights;
+        carry_save(&twos_a, &ones, ones, words[j], words[j + 1]);
+        carry_save(&twos_b, &ones, ones, words[j + 2], words[j + 3]);
+        carry_save(&fours_a, &twos, twos, twos_a, twos_b);
+        carry_save(&twos_a, &ones, ones, words[j + 4], words[j + 5]);
+        carry_save(&twos_b, &ones, ones, words[j + 6], words[j + 7]);
+        carry_save(&fours_b, &twos, twos, twos_a, twos_b);
+        carry_save(&eights, &fours, fours, fours_a, fours_b);
+        for (int p = 0; p < COUNT_PLANES; p++) {
+            uint64_t carry = planes[p] & eights;
+            planes[p] ^= eights;
+            eights = carry;
+        }
+        if (++groups == COUNT_FLUSH) {
+            for (int p = 0; p < COUNT_PLANES; p++) {
+                add_lanes(planes[p], 8 << p, live_cells, replicas);
+                planes[p] = 0;
+            }
+            groups = 0;
+        }
+    }
+    for (; j < n; j++) {
+        add_lanes(words[j], 1, live_cells, replicas);
+    }
+    for (int p = 0; p < COUNT_PLANES; p++) {
+        add_lanes(planes[p], 8 << p, live_cells, replicas);
+    }
+    add_lanes(ones, 1, live_cells, replicas);
+    add_lanes(twos, 2, live_cells, replicas);
+    add_lanes(fours, 4, live_cells, replicas);
+}
+
+// Advance the replicas set in running by one step into next_grid and count the live cells of every
+// replica. Each word holds the same cell of all the replicas, so the bit-sliced rule of the bit
+// engine updates 64 replicas at once, in a loop free of dependences between cells that the compiler
+// vectorises; the stopped replicas keep their cells. The row is counted in a second pass.
+static inline void ensemble_update_rows(uint64_t **ensemble_grid, uint64_t **next_grid, uint64_t running, const uint64_t sum_states[6], int *live_cells, master_str *master) {
+    int landscape = master->params.landscape;
+    int replicas = master->params.ensemble;
+    int counts[MAXREPLICAS] = {0};
+    uint64_t states[6];
+
+    memcpy(states, sum_states, sizeof(states));
+    #pragma omp parallel for schedule(static) reduction(+:counts[:MAXREPLICAS])
+    for (int i = 1; i <= landscape; i++) {
+        const uint64_t *up = ensemble_grid[i - 1];
+        const uint64_t *row = ensemble_grid[i];
+        const uint64_t *down = ensemble_grid[i + 1];
+        uint64_t *next = next_grid[i];
+
+        for (int j = 1; j <= landscape; j++) {
+            uint64_t cells = next_state(up[j], row[j], down[j], row[j - 1], row[j + 1], states);
+            next[j] = (cells & running) | (row[j] & ~running);
+        }
+        count_lanes(&next[1], landscape, counts, replicas);
+    }
+    memcpy(live_cells, counts, replicas * sizeof(int));
+}
+
+// Advance the running replicas of the ensemble by one step into next_grid and count the live cells
+// of every replica. The built-in rule runs the instance specialised on its constant states.
+void ensemble_update_cells(uint64_t **ensemble_grid, uint64_t **next_grid, uint64_t running, int *live_cells, master_str *master) {
+    uint64_t states[6];
+
+    if (rule_states(&master->params.rule, states)) {
+        ensemble_update_rows(ensemble_grid, next_grid, running, builtin_states, live_cells, master);
+    } else {
+        ensemble_update_rows(ensemble_grid, next_grid, running, states, live_cells, master);
+    }
+}
+
+// Copy replica k of the ensemble into the interior of the padded int cell grid.
+void unpack_ensemble_replica(uint64_t **ensemble_grid, int **cell_grid, int k, master_str *master) {
+    for (int i = 1; i <= master->params.landscape; i++) {
+        for (int j = 1; j <= master->params.landscape; j++) {
+            cell_grid[i][j] = (int) ((ensemble_grid[i][j] >> k) & 1);
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef BITLIB_H
+#define BITLIB_H
+
+#include <stdint.h>
+#include "structs.h"  // Including necessary structures like master_str
+
+// Number of cells stored in one packed word
+#define CELLBITS 64
+
+// Number of packed words needed for a padded row of cols interior cells plus two halo cells
+#define PACKED_WORDS(cols) (((cols) + 2 + CELLBITS - 1) / CELLBITS)
+
+// Bit planes of the per-replica counters of groups of eight live cells of an ensemble, and the groups
+// they count before they are added to the totals, so that they cannot overflow
+#define COUNT_PLANES 8
+#define COUNT_FLUSH 255
+
+// Number of packed words needed for a halo column of rows cells
+#define PACKED_COLUMN_WORDS(rows) (((rows) + CELLBITS - 1) / CELLBITS)
+
+// Packs the padded int cell grid (including halos) into packed words
+void pack_cells(int **cell_grid, uint64_t **packed_grid, master_str *master);
+
+// Unpacks the interior of the packed grid back into the padded int cell grid
+void unpack_cells(uint64_t **packed_grid, int **cell_grid, master_str *master);
+
+// Builds the per-word mask that selects the interior cells of a padded row
+void build_interior_mask(uint64_t *interior_mask, master_str *master);
+
+// Builds the per-word mask that selects the columns inside the periodic boundary band
+void build_boundary_mask(uint64_t *boundary_mask, int periodic_boundary_start, int periodic_boundary_end, master_str *master);
+
+// Applies the periodic and fixed top/bottom boundary conditions to a packed grid in the serial version
+void packed_periodic_boundary(uint64_t **packed_grid, uint64_t *boundary_mask, master_str *master);
+
+// Applies the fixed top/bottom boundary conditions to a packed grid in the parallel version
+void packed_adjust_boundaries(uint64_t **packed_grid, uint64_t *boundary_mask, cart_str cart, master_str *master);
+
+// Computes the next generation of the packed grid into next_grid and counts the live cells
+void packed_update_cells(uint64_t **packed_grid, uint64_t **next_grid, uint64_t *interior_mask, int *local_live_cells, master_str *master);
+
+// Copies the first and last interior columns of the packed grid into bit-packed column buffers
+void pack_halo_columns(uint64_t **packed_grid, uint64_t *left_column, uint64_t *right_column, master_str *master);
+
+// Copies a received bit-packed column buffer into the left or right halo column of the packed grid
+void unpack_halo_column(uint64_t **packed_grid, uint64_t *column, int col, master_str *master);
+
+// Initialises every replica of the ensemble, one bit of each cell word, from its own seed and density
+void initialize_ensemble_cells(uint64_t **ensemble_grid, int *live_cells, master_str *master);
+
+// Applies the periodic and fixed top/bottom boundary conditions to every replica of the ensemble
+void ensemble_periodic_boundary(uint64_t **ensemble_grid, int periodic_boundary_start, int periodic_boundary_end, master_str *master);
+
+// Advances the running replicas of the ensemble into next_grid and counts the live cells of every replica
+void ensemble_update_cells(uint64_t **ensemble_grid, uint64_t **next_grid, uint64_t running, int *live_cells, master_str *master);
+
+// Copies one replica of the ensemble into the padded int cell grid
+void unpack_ensemble_replica(uint64_t **ensemble_grid, int **cell_grid, int k, master_str *master);
+
+#endif // BITLIB_H
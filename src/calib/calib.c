@@ -4,61 +4,50 @@
 #include "structs.h"
 #include "arralloc.h"
 #include "misc.h"
+#include "mplib.h"
+#include "mem.h"
 #include <stdbool.h>
 
-// Compute the dimensions of the grid based on the landscape size and Cartesian grid dimensions.
-int check_divisibility(int landscape, int dimension, const char* dim_name, int rank) {
-    if (landscape % dimension != 0) {
-        if (rank == 0) {
-            printf("Error: Landscape is not perfectly divisible by %s dimension, use a number of processes that is a factor of the landscape value\n", dim_name);
-        }
-        return 0; // Exit if not divisible
-    }
-    return landscape / dimension; // Return the computed dimension
-}
+// Regions with fewer rows, such as the edge strips of the overlapped exchange, run on one thread.
+#define MIN_THREADED_ROWS 16
 
-// Refactored function
+// Compute the tile of this process in a block decomposition of the landscape over the Cartesian
+// grid. The landscape need not be divisible by the grid dimensions: tiles differ by at most one
+// row or column, the larger ones first.
 int compute_dimensions(master_str *master) {
     if (master->params.version == par2D) {
-        int LX = check_divisibility(master->params.landscape, master->cart.dims[0], "first", master->comm.rank);
-        if (!LX) return FAILED;
+        int landscape = master->params.landscape;
+        int smallest_rows = landscape / master->cart.dims[0];
+        int smallest_cols = landscape / master->cart.dims[1];
 
-        int LY = check_divisibility(master->params.landscape, master->cart.dims[1], "second", master->comm.rank);
-        if (!LY) return FAILED;
+        if (smallest_rows == 0 || smallest_cols == 0) {
+            if (master->comm.rank == 0) {
+                printf("Error: landscape %d is smaller than the %d x %d process grid\n", landscape, master->cart.dims[0], master->cart.dims[1]);
+            }
+            return FAILED;
+        }
 
-        master->dimensions.rows = LX;
-        master->dimensions.cols = LY;
+        block_decomposition(landscape, master->cart.dims[0], master->cart.coords[0], &master->dimensions.first_row, &master->dimensions.rows);
+        block_decomposition(landscape, master->cart.dims[1], master->cart.coords[1], &master->dimensions.first_col, &master->dimensions.cols);
+
+        // Deep halos are filled from the adjacent processes only, so they cannot be deeper than the smallest tile.
+        if (master->params.halo > smallest_rows || master->params.halo > smallest_cols) {
+            if (master->comm.rank == 0) {
+                printf("Error: halo depth %d is larger than the smallest %d x %d local tile\n", master->params.halo, smallest_rows, smallest_cols);
+            }
+            return FAILED;
+        }
     }
     else if (master->params.version == serial) {
         master->dimensions.rows = master->params.landscape;
         master->dimensions.cols = master->params.landscape;
+        master->dimensions.first_row = 0;
+        master->dimensions.first_col = 0;
     }
 
     return SUCCESS;
 }
 
-// Distribute cells from the global landscape to a smaller grid based on the process's subdomain.
-void distribute_cells(int **local_cell_grid, int **global_cell_grid, master_str *master) {
-    // Loop through each cell in the smaller grid to assign values from the global grid.
-    for (int i = 0; i < master->dimensions.rows; i++) {
-        for (int j = 0; j < master->dimensions.cols; j++) {
-            int global_row = master->cart.coords[0] * master->dimensions.rows + i;
-            int global_col = master->cart.coords[1] * master->dimensions.cols + j;
-            local_cell_grid[i][j] = global_cell_grid[global_row][global_col];
-        }
-    }
-}
-
-// Set all elements of the temporary cell array to zero.
-void zerotmpcell(int **reduction_cell_grid, master_str *master) {
-    // Loop through each element in the temporary grid and set its value to zero.
-    for (int i = 0; i < master->params.landscape; i++) {
-        for (int j = 0; j < master->params.landscape; j++) {
-            reduction_cell_grid[i][j] = 0;
-        }
-    }
-}
-
 // Copy data from the padded cell array to the smaller cell array.
 void copy_data_to_local_cell_grid(int **cell_grid, int **local_cell_grid, master_str *master) {
     // Loop through each cell in the padded grid and copy it to the corresponding position in the smaller grid.
@@ -69,16 +58,29 @@ void copy_data_to_local_cell_grid(int **cell_grid, int **local_cell_grid, master
     }
 }
 
-// Gather cells from the smaller grids of each process into the global temporary grid.
-void gather_cells(int **local_cell_grid, int **reduction_cell_grid, master_str *master) {
-    // Loop through each cell in the smaller grid and place its value in the correct position in the global grid.
-    for (int i = 0; i < master->dimensions.rows; i++) {
-        for (int j = 0; j < master->dimensions.cols; j++) {
-            int global_row = master->cart.coords[0] * master->dimensions.rows + i;
-            int global_col = master->cart.coords[1] * master->dimensions.cols + j;
-            reduction_cell_grid[global_row][global_col] = local_cell_grid[i][j];
+// Record the initial number of live cells and print the density information.
+void report_initial_cells(master_str *master, int live_cells) {
+    int landscape = master->params.landscape;
+    master->initialcells = live_cells;
+    if (master->comm.rank == 0) {
+        printf("automaton: rho = %f, live cells = %d, actual density = %f\n",
+               master->params.rho, live_cells, ((double) live_cells) / (landscape * landscape));
+    }
+}
+
+// Print the rule and neighbourhood the run uses.
+void report_rule(master_str *master) {
+    const rule_str *rule = &master->params.rule;
+    char sums[2 * RULE_SUMS + 1] = "";
+
+    for (int s = 0; s < RULE_SUMS; s++) {
+        if (rule->alive[s]) {
+            sprintf(sums + strlen(sums), "%s%d", sums[0] ? "," : "", s);
         }
     }
+    if (master->comm.rank == 0) {
+        printf("automaton: rule %s on the %s neighbourhood\n", sums[0] ? sums : "none", rule->neighbourhood == moore ? "Moore" : "von Neumann");
+    }
 }
 
 // Initialize the cells based on a probability and count the number of live cells.
@@ -102,19 +104,33 @@ void initialize_cells(int landscape, int **global_cell_grid, master_str *master,
     }
 
     *live_cells = initial_live_cells;  // Update the live cell count.
-    // Print the density information.
-    master->initialcells = initial_live_cells;
-    printf("automaton: rho = %f, live cells = %d, actual density = %f\n",
-           master->params.rho, initial_live_cells, ((double) initial_live_cells) / (landscape * landscape));
+    report_initial_cells(master, initial_live_cells);
 }
 
+// Initialize the interior cells of this process's tile from the counter-based generator, keyed on
+// the global position of each cell, and count the live cells of the tile.
+void initialize_tile_cells(int **cell_grid, master_str *master, int *local_live_cells) {
+    int live_cells = 0;
+    #pragma omp parallel for schedule(static) reduction(+:live_cells)
+    for (int i = 1; i <= master->dimensions.rows; i++) {
+        for (int j = 1; j <= master->dimensions.cols; j++) {
+            int global_row = master->dimensions.first_row + i - 1;
+            int global_col = master->dimensions.first_col + j - 1;
+            cell_grid[i][j] = (counter_uni(master->params.seed, global_row, global_col) < master->params.rho);
+            live_cells += cell_grid[i][j];
+        }
+    }
+    *local_live_cells = live_cells;
+}
+
+
 // Adjust the top boundary condition for cells, setting values based on Cartesian grid position.
 void adjust_top_boundary(int **cell_grid, cart_str cart, int periodic_boundary_start, int periodic_boundary_end, master_str *master) {
     // Check if the process is at the top boundary of the Cartesian grid.
     if (cart.coords[0] == 0) {
         // Loop through cells at the top boundary.
         for (int i = 1; i < master->dimensions.cols + 1; i++) {
-            int index = cart.coords[1] * master->dimensions.cols + i;
+            int index = master->dimensions.first_col + i;
             // Adjust cells not in the periodic boundary condition range.
             if (index < periodic_boundary_start || index > periodic_boundary_end) {
                 cell_grid[0][i] = 0;
@@ -129,7 +145,7 @@ void adjust_bottom_boundary(int **cell_grid, cart_str cart, int periodic_boundar
     if (cart.coords[0] == cart.dims[0] - 1) {
         // Loop through cells at the bottom boundary.
         for (int i = 1; i < master->dimensions.cols + 1; i++) {
-            int index = cart.coords[1] * master->dimensions.cols + i;
+            int index = master->dimensions.first_col + i;
             // Adjust cells not in the periodic boundary condition range.
             if (index < periodic_boundary_start || index > periodic_boundary_end) {
                 cell_grid[master->dimensions.rows + 1][i] = 0;
@@ -147,30 +163,256 @@ void adjust_boundaries(int **cell_grid, cart_str cart, int periodic_boundary_sta
 
 // Update each cell based on its neighbors' states and count the number of live cells.
 void update_cells(int **cell_grid, int **neighbor_grid, int *local_live_cells, master_str *master) {
-    *local_live_cells = 0;  // Reset the count of live cells.
+    const unsigned char *alive = master->params.rule.alive;
+    int live_cells = 0;  // Reset the count of live cells.
+    #pragma omp parallel for schedule(static) reduction(+:live_cells)
     for (int i = 1; i <= master->dimensions.rows; i++) {
         for (int j = 1; j <= master->dimensions.cols; j++) {
-            // If the cell has 2, 4, or 5 neighbors, it becomes or remains alive; otherwise, it dies.
-            if (neighbor_grid[i][j] == 2 || neighbor_grid[i][j] == 4 || neighbor_grid[i][j] == 5) {
-                cell_grid[i][j] = 1;
-                (*local_live_cells)++;  // Increment live cell count.
-            } else {
-                cell_grid[i][j] = 0;
-            }
+            // The rule table gives the next state for the neighbourhood sum without branching.
+            cell_grid[i][j] = alive[neighbor_grid[i][j]];
+            live_cells += cell_grid[i][j];
         }
     }
+    *local_live_cells = live_cells;
 }
 
-// Calculate the number of neighbors for each cell in the grid.
-void calculate_neighbors(int **cell_grid, int **neighbor_grid, master_str *master) {
+// Compute the next state of columns col_start..col_end of one row for a neighbourhood and number of
+// rule members fixed at compile time, so that each instance compiles to a branch-free vector loop
+// comparing the sum against the members held in registers.
+static inline int update_row_rule(const int *up, const int *row, const int *down, int *next, int col_start, int col_end,
+                                  const int diagonal, const int count, const rule_str *rule) {
+    const int m0 = rule->members[0], m1 = rule->members[1], m2 = rule->members[2], m3 = rule->members[3], m4 = rule->members[4];
+    const int invert = rule->invert;
+    int live_cells = 0;
+    for (int j = col_start; j <= col_end; j++) {
+        int sum = row[j] + up[j] + down[j] + row[j - 1] + row[j + 1];
+        if (diagonal) {
+            sum += up[j - 1] + up[j + 1] + down[j - 1] + down[j + 1];
+        }
+        int alive = (count > 0 && sum == m0) | (count > 1 && sum == m1) | (count > 2 && sum == m2) |
+                    (count > 3 && sum == m3) | (count > 4 && sum == m4);
+        alive ^= invert;
+        next[j] = alive;
+        live_cells += alive;
+    }
+    return live_cells;
+}
+
+// Compute the next state of columns col_start..col_end of one row from the rows above and below it,
+// writing it into next. Returns the live cells written. Dispatches to the kernel instance for the rule.
+int update_row_fused(const int *up, const int *row, const int *down, int *next, int col_start, int col_end, const rule_str *rule) {
+    int diagonal = (rule->neighbourhood == moore);
+    switch (rule->count + diagonal * (RULE_MEMBERS + 1)) {
+        case 0: return update_row_rule(up, row, down, next, col_start, col_end, 0, 0, rule);
+        case 1: return update_row_rule(up, row, down, next, col_start, col_end, 0, 1, rule);
+        case 2: return update_row_rule(up, row, down, next, col_start, col_end, 0, 2, rule);
+        case 3: return update_row_rule(up, row, down, next, col_start, col_end, 0, 3, rule);
+        case 4: return update_row_rule(up, row, down, next, col_start, col_end, 0, 4, rule);
+        case 5: return update_row_rule(up, row, down, next, col_start, col_end, 0, 5, rule);
+        case 6: return update_row_rule(up, row, down, next, col_start, col_end, 1, 0, rule);
+        case 7: return update_row_rule(up, row, down, next, col_start, col_end, 1, 1, rule);
+        case 8: return update_row_rule(up, row, down, next, col_start, col_end, 1, 2, rule);
+        case 9: return update_row_rule(up, row, down, next, col_start, col_end, 1, 3, rule);
+        case 10: return update_row_rule(up, row, down, next, col_start, col_end, 1, 4, rule);
+        default: return update_row_rule(up, row, down, next, col_start, col_end, 1, 5, rule);
+    }
+}
+
+// Compute the neighbourhood sum and apply the rule in a single pass over rows row_start..row_end and
+// columns col_start..col_end, writing the next generation into next_grid. Returns the live cells written.
+int update_cells_fused_region(int **cell_grid, int **next_grid, int row_start, int row_end, int col_start, int col_end, const rule_str *rule) {
+    int live_cells = 0;
+    #pragma omp parallel for schedule(static) reduction(+:live_cells) if (row_end - row_start >= MIN_THREADED_ROWS)
+    for (int i = row_start; i <= row_end; i++) {
+        live_cells += update_row_fused(cell_grid[i - 1], cell_grid[i], cell_grid[i + 1], next_grid[i], col_start, col_end, rule);
+    }
+    return live_cells;
+}
+
+// Compute the neighbourhood sum and apply the rule in a single pass, writing the next generation
+// into next_grid so that no intermediate neighbour grid is stored or read back.
+void update_cells_fused(int **cell_grid, int **next_grid, int *local_live_cells, master_str *master) {
+    *local_live_cells = update_cells_fused_region(cell_grid, next_grid, 1, master->dimensions.rows, 1, master->dimensions.cols, &master->params.rule);
+}
+
+// Allocate the change flags of the blocks of the tile. Every block starts as changed, so the first
+// steps compute the whole tile.
+void create_active_blocks(active_str *active, master_str *master) {
+    active->brows = (master->dimensions.rows + ACTIVE_BLOCK - 1) / ACTIVE_BLOCK;
+    active->bcols = (master->dimensions.cols + ACTIVE_BLOCK - 1) / ACTIVE_BLOCK;
+    int nblocks = active->brows * active->bcols;
+    active->changed = malloc(nblocks * sizeof(unsigned char));
+    active->dirty = malloc(nblocks * sizeof(unsigned char));
+    if (active->changed == NULL || active->dirty == NULL) {
+        handle_allocation_failure();
+    }
+    memset(active->changed, 1, nblocks * sizeof(unsigned char));
+    active->first = 1;
+    active->visited = 0;
+    active->computed = 0;
+    active->messages = 0;
+    active->skipped = 0;
+    active->last_report = master->start_step;
+}
+
+// Free the block arrays allocated by create_active_blocks.
+void free_active_blocks(active_str *active) {
+    free(active->changed);
+    free(active->dirty);
+}
+
+// Compute the next state of n cells of one row like update_row_fused, overwriting the generation in
+// next. Adds the change in live cells to delta and returns nonzero if any cell differs.
+static inline int update_row_changes(const int *up, const int *row, const int *down, int *next, int n, const unsigned char *rule, int *delta) {
+    int differ = 0;
+    int change = 0;
+    for (int j = 0; j < n; j++) {
+        int sum = row[j] + up[j] + down[j] + row[j - 1] + row[j + 1];
+        int alive = rule[sum];
+        differ |= alive ^ next[j];
+        change += alive - next[j];
+        next[j] = alive;
+    }
+    *delta += change;
+    return differ;
+}
+
+// Count the live interior cells of a grid.
+static int count_live_cells(int **cell_grid, master_str *master) {
+    int live_cells = 0;
     for (int i = 1; i <= master->dimensions.rows; i++) {
         for (int j = 1; j <= master->dimensions.cols; j++) {
+            live_cells += cell_grid[i][j];
+        }
+    }
+    return live_cells;
+}
+
+// Compute the next generation into next_grid like update_cells_fused, but only for the blocks that
+// may differ from the generation before the current one, which next_grid still holds. A block is
+// skipped when neither it, nor its four neighbouring blocks, nor the halo side it touches, flagged
+// in halo as top, bottom, left and right, changed over the last two steps: its neighbourhood is then
+// the one two steps back, so its next generation is the one already in next_grid. This skips still
+// lifes and period-2 oscillators alike. The live cells follow from those two steps back and the cells
+// that differ from them.
+int update_cells_active(int **cell_grid, int **next_grid, int halo[4], active_str *active, master_str *master) {
+    int rows = master->dimensions.rows;
+    int cols = master->dimensions.cols;
+    int brows = active->brows;
+    int bcols = active->bcols;
+
+    if (active->first) {
+        active->live_previous = count_live_cells(next_grid, master);
+        active->live_cells = count_live_cells(cell_grid, master);
+    }
+
+    for (int bi = 0; bi < brows; bi++) {
+        for (int bj = 0; bj < bcols; bj++) {
+            int b = bi * bcols + bj;
+            active->dirty[b] = active->changed[b]
+                || (bi > 0 && active->changed[b - bcols]) || (bi < brows - 1 && active->changed[b + bcols])
+                || (bj > 0 && active->changed[b - 1]) || (bj < bcols - 1 && active->changed[b + 1])
+                || (bi == 0 && halo[0]) || (bi == brows - 1 && halo[1])
+                || (bj == 0 && halo[2]) || (bj == bcols - 1 && halo[3]);
+        }
+    }
+
+    int delta = 0;
+    int computed = 0;
+    #pragma omp parallel for schedule(static) reduction(+:delta, computed)
+    for (int bi = 0; bi < brows; bi++) {
+        int r0 = bi * ACTIVE_BLOCK + 1;
+        int r1 = (r0 + ACTIVE_BLOCK - 1 <= rows) ? r0 + ACTIVE_BLOCK - 1 : rows;
+        unsigned char *dirty = &active->dirty[bi * bcols];
+        unsigned char *changed = &active->changed[bi * bcols];
+        for (int bj = 0; bj < bcols; bj++) {
+            if (!dirty[bj]) {
+                changed[bj] = 0;
+                continue;
+            }
+            int c0 = bj * ACTIVE_BLOCK + 1;
+            int n = (c0 + ACTIVE_BLOCK - 1 <= cols) ? ACTIVE_BLOCK : cols - c0 + 1;
+            int differ = 0;
+            for (int i = r0; i <= r1; i++) {
+                differ |= update_row_changes(&cell_grid[i - 1][c0], &cell_grid[i][c0], &cell_grid[i + 1][c0], &next_grid[i][c0], n, master->params.rule.alive, &delta);
+            }
+            changed[bj] = (differ != 0);
+            computed++;
+        }
+    }
+
+    // The grid that the first step overwrote did not hold a generation of the run.
+    if (active->first) {
+        memset(active->changed, 1, brows * bcols * sizeof(unsigned char));
+        active->first = 0;
+    }
+    int live_cells = active->live_previous + delta;
+    active->live_previous = active->live_cells;
+    active->live_cells = live_cells;
+    active->visited += brows * bcols;
+    active->computed += computed;
+    return active->live_cells;
+}
+
+// Find which edges of the tile may differ from two steps back, in the order of the sends of
+// send_halo_cells: bottom row, top row, right column and left column.
+void active_edges(active_str *active, int edges[4]) {
+    int last = (active->brows - 1) * active->bcols;
+    edges[0] = edges[1] = edges[2] = edges[3] = 0;
+    for (int bj = 0; bj < active->bcols; bj++) {
+        edges[0] |= active->changed[last + bj];
+        edges[1] |= active->changed[bj];
+    }
+    for (int bi = 0; bi < active->brows; bi++) {
+        edges[2] |= active->changed[bi * active->bcols + active->bcols - 1];
+        edges[3] |= active->changed[bi * active->bcols];
+    }
+}
+
+// Report the fraction of blocks skipped, and in parallel of halo messages sent empty, since the last report.
+void report_active_blocks(active_str *active, int step, master_str *master) {
+    double visited = active->visited;
+    double computed = active->computed;
+    double messages = active->messages;
+    double skipped = active->skipped;
+    if (master->params.version == par2D) {
+        visited = mpgsum(master->cart, &active->visited);
+        computed = mpgsum(master->cart, &active->computed);
+        messages = mpgsum(master->cart, &active->messages);
+        skipped = mpgsum(master->cart, &active->skipped);
+    }
+    if (master->comm.rank == 0 && visited > 0) {
+        if (messages > 0) {
+            printf("automaton: steps %d-%d skipped %.1f%% of blocks and sent %.1f%% of halo messages empty\n",
+                   active->last_report + 1, step, 100.0 * (1.0 - computed / visited), 100.0 * skipped / messages);
+        } else {
+            printf("automaton: steps %d-%d skipped %.1f%% of blocks\n",
+                   active->last_report + 1, step, 100.0 * (1.0 - computed / visited));
+        }
+    }
+    active->visited = 0;
+    active->computed = 0;
+    active->messages = 0;
+    active->skipped = 0;
+    active->last_report = step;
+}
+
+// Calculate the number of neighbors for the cells in rows row_start..row_end and columns col_start..col_end.
+void calculate_neighbors_region(int **cell_grid, int **neighbor_grid, int row_start, int row_end, int col_start, int col_end) {
+    #pragma omp parallel for schedule(static) if (row_end - row_start >= MIN_THREADED_ROWS)
+    for (int i = row_start; i <= row_end; i++) {
+        for (int j = col_start; j <= col_end; j++) {
             // Sum the states of the cell and its immediate neighbors to get the total number of active neighbors.
             neighbor_grid[i][j] = cell_grid[i][j] + cell_grid[i-1][j] + cell_grid[i+1][j] + cell_grid[i][j-1] + cell_grid[i][j+1];
         }
     }
 }
 
+// Calculate the number of neighbors for each cell in the grid.
+void calculate_neighbors(int **cell_grid, int **neighbor_grid, master_str *master) {
+    calculate_neighbors_region(cell_grid, neighbor_grid, 1, master->dimensions.rows, 1, master->dimensions.cols);
+}
+
 // Copy data from the smaller cell array back to the main cell array after calculations.
 void copy_data_to_cell_grid(int **cell_grid, int **local_cell_grid, master_str *master) {
     for (int i = 1; i <= master->dimensions.rows; i++) {
@@ -181,6 +423,15 @@ void copy_data_to_cell_grid(int **cell_grid, int **local_cell_grid, master_str *
     }
 }
 
+// Copy the interior cells between two grids that share the padded indexing, such as a cell grid and a deep halo grid.
+void copy_interior_cells(int **src_grid, int **dst_grid, master_str *master) {
+    for (int i = 1; i <= master->dimensions.rows; i++) {
+        for (int j = 1; j <= master->dimensions.cols; j++) {
+            dst_grid[i][j] = src_grid[i][j];
+        }
+    }
+}
+
 // Set halo cells to zero along the top and bottom boundaries of the grid to manage boundary conditions.
 void zero_top_bottom_halos(int **cell_grid, master_str *master) {
     for (int i = 0; i <= master->dimensions.rows + 1; i++) {
@@ -199,9 +450,151 @@ void zero_left_right_halos(int **cell_grid, master_str *master) {
     }
 }
 
+// Starts writing the interior of cell_grid to snap_<step>.pbm every snapfreq steps. The tile is
+// packed into the snapshot buffer and written with non-blocking MPI-IO while the next steps run;
+// only the previous snapshot, if still in flight, is waited for.
+void take_snapshot(int **cell_grid, int step, master_str *master) {
+    char snapfile[32];
+
+    if (master->params.snapfreq == 0 || step % master->params.snapfreq != 0) {
+        return;
+    }
+    if (!mpwrite_supported(master)) {
+        if (master->comm.rank == 0) {
+            printf("automaton: snapshots need tiles of at least 8 rows, disabled\n");
+        }
+        master->params.snapfreq = 0;
+        return;
+    }
+
+    double snapshot_start = gettime();
+    sprintf(snapfile, "snap_%06d.pbm", step);
+    mpwrite_cells_start(snapfile, cell_grid, 1, &master->snapshot.image, master->cart, master);
+    master->snapshot.count++;
+    master->snapshot.time += gettime() - snapshot_start;
+}
+
+// Completes the last snapshot and reports the time the step loop spent on each snapshot, the
+// slowest process counting, and relative to the time of the loop without the snapshots.
+void finish_snapshots(master_str *master) {
+    if (master->snapshot.count == 0) {
+        return;
+    }
+
+    double snapshot_start = gettime();
+    mpwrite_cells_free(&master->snapshot.image);
+    master->snapshot.time += gettime() - snapshot_start;
+
+    double loop_time = gettime() - master->time.start;
+    double overhead = master->snapshot.time / (loop_time - master->snapshot.time);
+    double snapshot_max = mpgmax(master->cart, &master->snapshot.time);
+    double overhead_max = mpgmax(master->cart, &overhead);
+
+    if (master->comm.rank == 0) {
+        printf("automaton: %d snapshots, %f s per snapshot in the step loop, overhead %.2f%% of the loop without snapshots\n",
+               master->snapshot.count, snapshot_max / master->snapshot.count, 100.0 * overhead_max);
+    }
+}
+
+// Writes the cells after the given step to checkpoint.dat every checkpointfreq steps. The file is
+// written under a temporary name and renamed once complete, so a failure during the write leaves
+// the previous checkpoint intact.
+void take_checkpoint(int **cell_grid, int step, master_str *master) {
+    checkpoint_str header;
+
+    if (master->params.checkpointfreq == 0 || step % master->params.checkpointfreq != 0) {
+        return;
+    }
+
+    memset(&header, 0, sizeof(header));  // Keep the padding bytes of the file deterministic
+    header.magic = CHECKPOINT_MAGIC;
+    header.landscape = master->params.landscape;
+    header.step = step;
+    header.initialcells = master->initialcells;
+    header.seed = master->params.seed;
+    header.rho = master->params.rho;
+    header.neighbourhood = master->params.rule.neighbourhood;
+    memcpy(header.alive, master->params.rule.alive, sizeof(header.alive));
+
+    double checkpoint_start = gettime();
+    if (mpwrite_checkpoint("checkpoint.dat.tmp", cell_grid, &header, master->cart, master) != 0) {
+        if (master->comm.rank == 0) {
+            printf("automaton: could not write checkpoint.dat.tmp, checkpoint on step %d skipped\n", step);
+        }
+        return;
+    }
+    if (master->comm.rank == 0) {
+        if (rename("checkpoint.dat.tmp", "checkpoint.dat") != 0) {
+            printf("automaton: could not rename checkpoint.dat.tmp to checkpoint.dat, checkpoint on step %d skipped\n", step);
+            return;
+        }
+        printf("automaton: checkpoint written on step %d in %f s\n", step, gettime() - checkpoint_start);
+    }
+}
+
+// Reads the header of the -restart checkpoint, if any, and takes the landscape, the seed, the density,
+// the initial live cells and the step to resume from out of it, before the dimensions are computed.
+// The rule must be the one the checkpoint was written with; -maxstep and -printfreq come from the
+// command line, so a restart may run further than the run that wrote it.
+int load_checkpoint_header(master_str *master) {
+    checkpoint_str header;
+
+    master->start_step = 0;
+    if (master->params.restart == NULL) {
+        return SUCCESS;
+    }
+
+    if (mpread_checkpoint_header(master->params.restart, &header, master->cart) != 0) {
+        if (master->comm.rank == 0) {
+            printf("Error: cannot read checkpoint file %s\n", master->params.restart);
+        }
+        return FAILED;
+    }
+
+    // The rule was parsed and checked against the engine with the other options, so a checkpoint
+    // taken under another rule is refused rather than continued under the rule of the command line.
+    if (header.neighbourhood != master->params.rule.neighbourhood ||
+            memcmp(header.alive, master->params.rule.alive, sizeof(header.alive)) != 0) {
+        if (master->comm.rank == 0) {
+            printf("Error: checkpoint file %s was written with -neighbourhood %s -rule ", master->params.restart,
+                   (header.neighbourhood == moore) ? "moore" : "vonneumann");
+            for (int s = 0, n = 0; s < RULE_SUMS; s++) {
+                if (header.alive[s]) {
+                    printf("%s%d", n++ ? "," : "", s);
+                }
+            }
+            printf(", which the restart must be given too\n");
+        }
+        return FAILED;
+    }
+
+    master->params.landscape = header.landscape;
+    master->params.seed = header.seed;
+    master->params.rho = header.rho;
+    master->initialcells = header.initialcells;
+    master->start_step = header.step;
+
+    if (master->comm.rank == 0) {
+        printf("automaton: restarting from %s after step %d\n", master->params.restart, header.step);
+    }
+    return SUCCESS;
+}
+
+// Check whether the live cells have fallen below or risen above the termination thresholds, relative
+// to the initial live cells.
+bool out_of_threshold_range(int ncell, int initialcells) {
+    return ncell < 0.75 * initialcells || ncell > 1.33 * initialcells;
+}
+
 bool should_terminate(int ncell, master_str *master, int step) {
-    if (ncell < 0.75 * master->initialcells || ncell > 1.33 * master->initialcells) {
-        printf("Terminating early: number of live cells out of threshold range on step %d\n", step);
+    // Benchmark trials always run the same number of steps
+    if (master->params.bench > 0) {
+        return false;
+    }
+    if (out_of_threshold_range(ncell, master->initialcells)) {
+        if (master->comm.rank == 0) {
+            printf("Terminating early: number of live cells out of threshold range on step %d\n", step);
+        }
         return true;  // Conditions met, suggest termination
     }
     return false;  // Conditions not met, continue simulation
@@ -4,21 +4,21 @@
 #include "structs.h"  // Including necessary structures like cart_str, master_str, etc.
 #include <stdbool.h>
 
-// Distributes cell data from a large cell array to smaller, more manageable arrays
-void distribute_cells(int **local_cell_grid, int **global_cell_grid, master_str *master);
-
-// Zeroes out the temporary cell array
-void zerotmpcell(int **reduction_cell_grid, master_str *master);
-
 // Copies data from a general cell array to a smaller cell array
 void copy_data_to_local_cell_grid(int **cell_grid, int **local_cell_grid, master_str *master);
 
-// Gathers processed cell data from smaller arrays into a temporary array
-void gather_cells(int **local_cell_grid, int **reduction_cell_grid, master_str *master);
-
 // Initializes cell data for a given landscape, setting live cells based on parameters
 void initialize_cells(int landscape, int **global_cell_grid, master_str *master, int *live_cells);
 
+// Initializes the cells of the local tile from a counter-based generator keyed on their global position
+void initialize_tile_cells(int **cell_grid, master_str *master, int *local_live_cells);
+
+// Prints the rule and neighbourhood of the run
+void report_rule(master_str *master);
+
+// Records the initial number of live cells and prints the density information
+void report_initial_cells(master_str *master, int live_cells);
+
 // Adjusts the top boundary of the cell grid based on predefined boundary conditions
 void adjust_top_boundary(int **cell_grid, cart_str cart, int periodic_boundary_start, int periodic_boundary_end, master_str *master);
 
@@ -28,15 +28,45 @@ void adjust_bottom_boundary(int **cell_grid, cart_str cart, int periodic_boundar
 // Adjusts the top and bottom boundaries of the cell grid
 void adjust_boundaries(int **cell_grid, cart_str cart, int periodic_boundary_start, int periodic_boundary_end, master_str *master);
 
-// Updates cell states based on neighbor data
+// Updates cell states from the neighbour sums through the rule table
 void update_cells(int **cell_grid, int **neighbor_grid, int *local_live_cells, master_str *master);
 
+// Computes the next cell states of part of one row from explicit rows above and below and returns its live cells
+int update_row_fused(const int *up, const int *row, const int *down, int *next, int col_start, int col_end, const rule_str *rule);
+
+// Computes the next cell states of a rectangular region into a second grid and returns its live cells
+int update_cells_fused_region(int **cell_grid, int **next_grid, int row_start, int row_end, int col_start, int col_end, const rule_str *rule);
+
+// Computes the next cell states into a second grid in one pass without a neighbour grid
+void update_cells_fused(int **cell_grid, int **next_grid, int *local_live_cells, master_str *master);
+
+// Allocates the per-block change flags and live counts of the tile for -active
+void create_active_blocks(active_str *active, master_str *master);
+
+// Frees the block arrays of -active
+void free_active_blocks(active_str *active);
+
+// Computes the next cell states into a second grid for the blocks that may have changed and returns the live cells
+int update_cells_active(int **cell_grid, int **next_grid, int halo[4], active_str *active, master_str *master);
+
+// Flags the edges of the tile that may differ from two steps back
+void active_edges(active_str *active, int edges[4]);
+
+// Reports the fraction of blocks skipped and halo messages sent empty since the last report
+void report_active_blocks(active_str *active, int step, master_str *master);
+
+// Calculates the number of neighboring live cells for the cells of a rectangular region
+void calculate_neighbors_region(int **cell_grid, int **neighbor_grid, int row_start, int row_end, int col_start, int col_end);
+
 // Calculates the number of neighboring live cells for each cell in the array
 void calculate_neighbors(int **cell_grid, int **neighbor_grid, master_str *master);
 
 // Copies data from a smaller cell array back to the main cell array
 void copy_data_to_cell_grid(int **cell_grid, int **local_cell_grid, master_str *master);
 
+// Copies the interior cells between two grids with the same padded indexing
+void copy_interior_cells(int **src_grid, int **dst_grid, master_str *master);
+
 // Clears data in the top and bottom halo regions of the cell grid
 void zero_top_bottom_halos(int **cell_grid, master_str *master);
 
@@ -49,6 +79,21 @@ void periodic_boundary(int **cell_grid, master_str *master);
 // Computes the dimensions for the cell grid based on the master settings
 int compute_dimensions(master_str *master);
 
+// Starts an asynchronous binary snapshot of the cells every snapfreq steps
+void take_snapshot(int **cell_grid, int step, master_str *master);
+
+// Completes the last snapshot and reports the snapshot overhead
+void finish_snapshots(master_str *master);
+
+// Writes a checkpoint of the cells every checkpointfreq steps
+void take_checkpoint(int **cell_grid, int step, master_str *master);
+
+// Reads the parameters and the step to resume from out of the -restart checkpoint file
+int load_checkpoint_header(master_str *master);
+
+// Checks the live cells against the termination thresholds relative to the initial live cells
+bool out_of_threshold_range(int ncell, int initialcells);
+
 // Terminates the calculation if the grid exceeds or decreases past a threshold
 bool should_terminate(int ncell, master_str *master, int step);
 
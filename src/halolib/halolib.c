@@ -0,0 +1,407 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+#include "structs.h"
+#include "halolib.h"
+#include "mplib.h"
+#include "mem.h"
+
+// Neighbours in the arrays of halo_str.
+#define UP 0
+#define DOWN 1
+#define LEFT 2
+#define RIGHT 3
+
+// Tag of the notifications between neighbours on the node, apart from the tags of the halo messages.
+#define NOTIFY_TAG 5
+
+// Index of the grid of the steps that cell_grid is.
+static int grid_index(halo_str *halo, int **cell_grid) {
+    return (cell_grid == halo->grids[0]) ? 0 : 1;
+}
+
+// Copy every cell of a padded grid, halos included.
+static void copy_grid(int **src, int **dst, master_str *master) {
+    for (int i = 0; i <= master->dimensions.rows + 1; i++) {
+        memcpy(dst[i], src[i], (master->dimensions.cols + 2) * sizeof(int));
+    }
+}
+
+// Rows and columns of the tile of a neighbour, which follow from its coordinates as the tile of this
+// process does.
+static void neighbour_tile(int neighbour, int *rows, int *cols, master_str *master) {
+    int coords[ndims], first;
+
+    MPI_Cart_coords(master->cart.comm2d, neighbour, ndims, coords);
+    block_decomposition(master->params.landscape, master->cart.dims[0], coords[0], &first, rows);
+    block_decomposition(master->params.landscape, master->cart.dims[1], coords[1], &first, cols);
+}
+
+// Find the neighbours on the node and the edges of their shared grids that fill the halos: the last
+// row of the one above, the first row of the one below, the last column of the one on the left and
+// the first column of the one on the right. The others keep being reached by messages.
+static void find_peers(halo_str *halo, master_str *master) {
+    cart_str cart = master->cart;
+    dir_str *remote[4] = {&halo->remote.up, &halo->remote.down, &halo->remote.left, &halo->remote.right};
+    int neighbours[4] = {cart.up.val, cart.down.val, cart.left.val, cart.right.val};
+    MPI_Group grid_group, node_group;
+
+    MPI_Comm_group(cart.comm2d, &grid_group);
+    MPI_Comm_group(halo->node_comm, &node_group);
+    halo->links = 0;
+    for (int d = 0; d < 4; d++) {
+        int node_rank = MPI_UNDEFINED;
+        halo->peer[d] = MPI_PROC_NULL;
+        if (neighbours[d] == MPI_PROC_NULL) {
+            continue;
+        }
+        MPI_Group_translate_ranks(grid_group, 1, &neighbours[d], node_group, &node_rank);
+        if (node_rank == MPI_UNDEFINED) {
+            continue;
+        }
+
+        int rows, cols;
+        MPI_Aint size;
+        int disp_unit;
+        int *base;
+        neighbour_tile(neighbours[d], &rows, &cols, master);
+        MPI_Win_shared_query(halo->win, node_rank, &size, &disp_unit, &base);
+
+        int offsets[4] = {rows * (cols + 2) + 1, cols + 3, cols + 2 + cols, cols + 3};
+        for (int g = 0; g < 2; g++) {
+            halo->edges[d][g] = base + g * (rows + 2) * (cols + 2) + offsets[d];
+        }
+        halo->width[d] = cols + 2;
+        halo->peer[d] = neighbours[d];
+        remote[d]->val = MPI_PROC_NULL;
+        halo->links++;
+    }
+    MPI_Group_free(&grid_group);
+    MPI_Group_free(&node_group);
+}
+
+// Allocate both grids of the steps in a window shared by the processes of the node, copying the
+// grids of the caller into them. Each process allocates its own part of the window, so its pages are
+// first touched on its own NUMA node, and holds a passive epoch on the whole window until free_halo.
+static void create_shared_grids(halo_str *halo, int ***cell_grid, int ***neighbor_grid, master_str *master) {
+    int rows = master->dimensions.rows;
+    int cols = master->dimensions.cols;
+    MPI_Aint size = 2 * (MPI_Aint) (rows + 2) * (cols + 2) * sizeof(int);
+    MPI_Info info;
+    int *base;
+
+    MPI_Comm_split_type(master->cart.comm2d, MPI_COMM_TYPE_SHARED, master->comm.rank, MPI_INFO_NULL, &halo->node_comm);
+    MPI_Info_create(&info);
+    MPI_Info_set(info, "alloc_shared_noncontig", "true");
+    MPI_Win_allocate_shared(size, sizeof(int), info, halo->node_comm, &base, &halo->win);
+    MPI_Info_free(&info);
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, halo->win);
+
+    halo->saved[0] = *cell_grid;
+    halo->saved[1] = *neighbor_grid;
+    for (int g = 0; g < 2; g++) {
+        halo->grids[g] = (int**) malloc((rows + 2) * sizeof(int*));
+        if (halo->grids[g] == NULL) {
+            handle_allocation_failure();
+        }
+        for (int i = 0; i < rows + 2; i++) {
+            halo->grids[g][i] = base + (g * (rows + 2) + i) * (cols + 2);
+        }
+        copy_grid(halo->saved[g], halo->grids[g], master);
+    }
+    *cell_grid = halo->grids[0];
+    *neighbor_grid = halo->grids[1];
+    find_peers(halo, master);
+}
+
+// Create a window on each grid of the steps and the group of the neighbours, and describe the halo
+// of each neighbour that an edge of the tile is put into: the bottom halo row of the one above, the
+// top halo row of the one below, the right halo column of the one on the left and the left halo
+// column of the one on the right. The columns of a neighbour have the stride of its own rows.
+static void create_grid_windows(halo_str *halo, master_str *master) {
+    cart_str cart = master->cart;
+    int neighbours[4] = {cart.up.val, cart.down.val, cart.left.val, cart.right.val};
+    int members[4];
+    int nmembers = 0;
+    MPI_Aint size = (MPI_Aint) (master->dimensions.rows + 2) * (master->dimensions.cols + 2) * sizeof(int);
+    MPI_Group grid_group;
+
+    for (int g = 0; g < 2; g++) {
+        MPI_Win_create(halo->grids[g][0], size, sizeof(int), MPI_INFO_NULL, cart.comm2d, &halo->grid_wins[g]);
+    }
+
+    for (int d = 0; d < 4; d++) {
+        int rows, cols, seen = 0;
+        halo->target_types[d] = MPI_DATATYPE_NULL;
+        if (neighbours[d] == MPI_PROC_NULL) {
+            continue;
+        }
+        for (int m = 0; m < nmembers; m++) {
+            seen = seen || members[m] == neighbours[d];
+        }
+        if (!seen) {
+            members[nmembers++] = neighbours[d];
+        }
+
+        neighbour_tile(neighbours[d], &rows, &cols, master);
+        MPI_Aint disps[4] = {(MPI_Aint) (rows + 1) * (cols + 2) + 1, 1, 2 * cols + 3, cols + 2};
+        halo->target_disps[d] = disps[d];
+        if (d == UP || d == DOWN) {
+            MPI_Type_dup(halo->row_type, &halo->target_types[d]);
+        } else {
+            MPI_Type_vector(rows, 1, cols + 2, MPI_INT, &halo->target_types[d]);
+            MPI_Type_commit(&halo->target_types[d]);
+        }
+    }
+
+    MPI_Comm_group(cart.comm2d, &grid_group);
+    MPI_Group_incl(grid_group, nmembers, members, &halo->group);
+    MPI_Group_free(&grid_group);
+}
+
+// Put the edges of the current grid into the halos of the neighbours. The grid is exposed to the
+// neighbours and their grids are accessed in one epoch of the window of the grid, which every
+// process is on, the fused engine swapping all the grids on the same steps.
+static void put_edges(halo_str *halo, int **cell_grid, master_str *master) {
+    int rows = master->dimensions.rows;
+    int cols = master->dimensions.cols;
+    int neighbours[4] = {master->cart.up.val, master->cart.down.val, master->cart.left.val, master->cart.right.val};
+    int *edges[4] = {&cell_grid[1][1], &cell_grid[rows][1], &cell_grid[1][1], &cell_grid[1][cols]};
+    MPI_Datatype types[4] = {halo->row_type, halo->row_type, halo->column_type, halo->column_type};
+    MPI_Win win = halo->grid_wins[grid_index(halo, cell_grid)];
+
+    MPI_Win_post(halo->group, 0, win);
+    MPI_Win_start(halo->group, 0, win);
+    for (int d = 0; d < 4; d++) {
+        if (neighbours[d] != MPI_PROC_NULL) {
+            MPI_Put(edges[d], 1, types[d], neighbours[d], halo->target_disps[d], 1, halo->target_types[d], win);
+        }
+    }
+}
+
+// Build the datatype of the edges or halos of a grid that go to or come from one neighbour, at their
+// absolute addresses, from those of the directions taken in the given order.
+static void neighbour_type(int *cells[4], const int order[4], int neighbours[4], int neighbour, MPI_Datatype types[4], MPI_Datatype *type) {
+    int lengths[4];
+    MPI_Aint addresses[4];
+    MPI_Datatype members[4];
+    int n = 0;
+
+    for (int k = 0; k < 4; k++) {
+        int d = order[k];
+        if (neighbours[d] == neighbour) {
+            lengths[n] = 1;
+            MPI_Get_address(cells[d], &addresses[n]);
+            members[n++] = types[d];
+        }
+    }
+    MPI_Type_create_struct(n, lengths, addresses, members, type);
+    MPI_Type_commit(type);
+}
+
+// Set up the neighbourhood collective on a graph of the distinct neighbours of the process grid. A
+// periodic dimension of one or two processes makes the same process the neighbour both up and down,
+// and MPI implementations differ in how they match the two messages of a Cartesian collective, so
+// each neighbour is sent a single message holding every edge it needs, in the order up, down, left,
+// right, and the halos received from it are taken in the order it sends them: the halo below first
+// from the process that sends it its top row, and so on.
+static void create_neighbour_exchange(halo_str *halo, master_str *master) {
+    static const int send_order[4] = {UP, DOWN, LEFT, RIGHT};
+    static const int recv_order[4] = {DOWN, UP, RIGHT, LEFT};
+    int rows = master->dimensions.rows;
+    int cols = master->dimensions.cols;
+    int neighbours[4] = {master->cart.up.val, master->cart.down.val, master->cart.left.val, master->cart.right.val};
+    MPI_Datatype types[4] = {halo->row_type, halo->row_type, halo->column_type, halo->column_type};
+    int distinct[4];
+    int weights[4] = {1, 1, 1, 1};  // Equal weights, MPI_UNWEIGHTED tripping the bounds checks of the compiler
+
+    halo->nneighbours = 0;
+    for (int d = 0; d < 4; d++) {
+        int seen = (neighbours[d] == MPI_PROC_NULL);
+        for (int n = 0; n < halo->nneighbours; n++) {
+            seen = seen || distinct[n] == neighbours[d];
+        }
+        if (!seen) {
+            distinct[halo->nneighbours++] = neighbours[d];
+        }
+    }
+    MPI_Dist_graph_create_adjacent(master->cart.comm2d, halo->nneighbours, distinct, weights,
+                                   halo->nneighbours, distinct, weights, MPI_INFO_NULL, 0, &halo->graph_comm);
+
+    for (int g = 0; g < 2; g++) {
+        int **grid = halo->grids[g];
+        int *edges[4] = {&grid[1][1], &grid[rows][1], &grid[1][1], &grid[1][cols]};
+        int *halos[4] = {&grid[0][1], &grid[rows + 1][1], &grid[1][0], &grid[1][cols + 1]};
+        for (int n = 0; n < halo->nneighbours; n++) {
+            neighbour_type(edges, send_order, neighbours, distinct[n], types, &halo->send_types[g][n]);
+            neighbour_type(halos, recv_order, neighbours, distinct[n], types, &halo->recv_types[g][n]);
+        }
+    }
+}
+
+// Set up the halo exchange of -exchange for the steps of par_process.
+void create_halo(halo_str *halo, int ***cell_grid, int ***neighbor_grid, MPI_Datatype row_type, MPI_Datatype column_type, master_str *master) {
+    halo->exchange = master->params.exchange;
+    halo->row_type = row_type;
+    halo->column_type = column_type;
+    halo->remote = master->cart;
+    halo->grids[0] = *cell_grid;
+    halo->grids[1] = *neighbor_grid;
+    halo->links = 0;
+    for (int r = 0; r < 16; r++) {
+        halo->reqs[r] = MPI_REQUEST_NULL;
+    }
+
+    if (halo->exchange == persistent_exchange) {
+        for (int g = 0; g < 2; g++) {
+            init_halo_exchange(halo->grids[g], row_type, column_type, master->cart, halo->persistent[g], master);
+        }
+    } else if (halo->exchange == neighbour_exchange) {
+        create_neighbour_exchange(halo, master);
+    } else if (halo->exchange == rma_exchange) {
+        create_grid_windows(halo, master);
+    } else if (halo->exchange == shared_exchange) {
+        create_shared_grids(halo, cell_grid, neighbor_grid, master);
+        int local[2] = {halo->links, (master->cart.up.val != MPI_PROC_NULL) + (master->cart.down.val != MPI_PROC_NULL) +
+                                     (master->cart.left.val != MPI_PROC_NULL) + (master->cart.right.val != MPI_PROC_NULL)};
+        int total[2];
+        MPI_Reduce(local, total, 2, MPI_INT, MPI_SUM, 0, master->cart.comm2d);
+        if (master->comm.rank == 0) {
+            printf("automaton: shared-memory halo exchange, %d of %d halos read within a node\n", total[0], total[1]);
+        }
+    }
+}
+
+// Start the exchange of the halos of the current grid. The persistent exchange starts the requests
+// created for the grid, and the neighbour exchange a single collective over the distinct neighbours.
+// The RMA exchange puts the edges straight into the halos of the neighbours. The shared exchange
+// tells the neighbours on the node that the edges of the grid are complete, the last step having
+// written them, and that the process is done reading their other grid, into which they may now
+// write the next step.
+void post_halo(halo_str *halo, int **cell_grid, master_str *master) {
+    static const int counts[4] = {1, 1, 1, 1};
+    static const MPI_Aint disps[4] = {0, 0, 0, 0};
+    int g = grid_index(halo, cell_grid);
+
+    if (halo->exchange == persistent_exchange) {
+        MPI_Startall(8, halo->persistent[g]);
+        return;
+    }
+    if (halo->exchange == neighbour_exchange) {
+        MPI_Ineighbor_alltoallw(MPI_BOTTOM, counts, disps, halo->send_types[g],
+                                MPI_BOTTOM, counts, disps, halo->recv_types[g], halo->graph_comm, &halo->reqs[0]);
+        return;
+    }
+    if (halo->exchange == rma_exchange) {
+        put_edges(halo, cell_grid, master);
+        return;
+    }
+    start_halo_exchange(cell_grid, halo->row_type, halo->column_type, halo->remote, halo->reqs, master);
+    if (halo->exchange != shared_exchange) {
+        return;
+    }
+    MPI_Win_sync(halo->win);
+    for (int d = 0; d < 4; d++) {
+        if (halo->peer[d] != MPI_PROC_NULL) {
+            MPI_Isend(NULL, 0, MPI_INT, halo->peer[d], NOTIFY_TAG, master->cart.comm2d, &halo->reqs[8 + 2 * d]);
+            MPI_Irecv(NULL, 0, MPI_INT, halo->peer[d], NOTIFY_TAG, master->cart.comm2d, &halo->reqs[9 + 2 * d]);
+        }
+    }
+}
+
+// Complete the exchange started by post_halo. The RMA exchange closes the epoch of the window of the
+// grid. Once the neighbours on the node have said their edges are complete, the shared exchange
+// copies the halos straight out of their shared grids.
+void complete_halo(halo_str *halo, int **cell_grid, master_str *master) {
+    if (halo->exchange == persistent_exchange) {
+        MPI_Waitall(8, halo->persistent[grid_index(halo, cell_grid)], MPI_STATUSES_IGNORE);
+        return;
+    }
+    if (halo->exchange == neighbour_exchange) {
+        MPI_Wait(&halo->reqs[0], MPI_STATUS_IGNORE);
+        return;
+    }
+    if (halo->exchange == rma_exchange) {
+        // The puts of this process are done, then those of the neighbours into its halos.
+        MPI_Win win = halo->grid_wins[grid_index(halo, cell_grid)];
+        MPI_Win_complete(win);
+        MPI_Win_wait(win);
+        return;
+    }
+    if (halo->exchange != shared_exchange) {
+        wait_halo_exchange(halo->reqs);
+        return;
+    }
+    MPI_Waitall(16, halo->reqs, MPI_STATUSES_IGNORE);
+    MPI_Win_sync(halo->win);
+
+    int rows = master->dimensions.rows;
+    int cols = master->dimensions.cols;
+    int g = grid_index(halo, cell_grid);
+    if (halo->peer[UP] != MPI_PROC_NULL) {
+        memcpy(&cell_grid[0][1], halo->edges[UP][g], cols * sizeof(int));
+    }
+    if (halo->peer[DOWN] != MPI_PROC_NULL) {
+        memcpy(&cell_grid[rows + 1][1], halo->edges[DOWN][g], cols * sizeof(int));
+    }
+    if (halo->peer[LEFT] != MPI_PROC_NULL) {
+        int *edge = halo->edges[LEFT][g];
+        for (int i = 1; i <= rows; i++) {
+            cell_grid[i][0] = edge[(i - 1) * halo->width[LEFT]];
+        }
+    }
+    if (halo->peer[RIGHT] != MPI_PROC_NULL) {
+        int *edge = halo->edges[RIGHT][g];
+        for (int i = 1; i <= rows; i++) {
+            cell_grid[i][cols + 1] = edge[(i - 1) * halo->width[RIGHT]];
+        }
+    }
+}
+
+// Free the halo exchange. The shared grids are copied back into the grids of the caller, the
+// current generation into the grid passed as cell_grid, before the window is freed.
+void free_halo(halo_str *halo, int ***cell_grid, int ***neighbor_grid, master_str *master) {
+    if (halo->exchange == persistent_exchange) {
+        for (int g = 0; g < 2; g++) {
+            for (int r = 0; r < 8; r++) {
+                MPI_Request_free(&halo->persistent[g][r]);
+            }
+        }
+        return;
+    }
+    if (halo->exchange == neighbour_exchange) {
+        for (int g = 0; g < 2; g++) {
+            for (int n = 0; n < halo->nneighbours; n++) {
+                MPI_Type_free(&halo->send_types[g][n]);
+                MPI_Type_free(&halo->recv_types[g][n]);
+            }
+        }
+        MPI_Comm_free(&halo->graph_comm);
+        return;
+    }
+    if (halo->exchange == rma_exchange) {
+        for (int d = 0; d < 4; d++) {
+            if (halo->target_types[d] != MPI_DATATYPE_NULL) {
+                MPI_Type_free(&halo->target_types[d]);
+            }
+        }
+        MPI_Group_free(&halo->group);
+        MPI_Win_free(&halo->grid_wins[0]);
+        MPI_Win_free(&halo->grid_wins[1]);
+        return;
+    }
+    if (halo->exchange != shared_exchange) {
+        return;
+    }
+    copy_grid(*cell_grid, halo->saved[0], master);
+    copy_grid(*neighbor_grid, halo->saved[1], master);
+    *cell_grid = halo->saved[0];
+    *neighbor_grid = halo->saved[1];
+
+    MPI_Win_unlock_all(halo->win);
+    MPI_Win_free(&halo->win);
+    MPI_Comm_free(&halo->node_comm);
+    free(halo->grids[0]);
+    free(halo->grids[1]);
+}
@@ -0,0 +1,20 @@
+#ifndef HALOLIB_H
+#define HALOLIB_H
+
+#include <mpi.h>
+#include "structs.h"  // Including necessary structures like halo_str and master_str
+
+// Sets up the halo exchange of -exchange for the steps of par_process. The shared exchange moves both
+// grids into shared memory, so the grid pointers stand for the shared grids until free_halo
+void create_halo(halo_str *halo, int ***cell_grid, int ***neighbor_grid, MPI_Datatype row_type, MPI_Datatype column_type, master_str *master);
+
+// Starts the exchange of the halos of the current grid
+void post_halo(halo_str *halo, int **cell_grid, master_str *master);
+
+// Completes the exchange started by post_halo, after which the halos of the current grid are filled
+void complete_halo(halo_str *halo, int **cell_grid, master_str *master);
+
+// Frees the halo exchange, putting the grids of the caller back with the current generation in cell_grid
+void free_halo(halo_str *halo, int ***cell_grid, int ***neighbor_grid, master_str *master);
+
+#endif // HALOLIB_H
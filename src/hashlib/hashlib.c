@@ -0,0 +1,464 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "structs.h"
+#include "hashlib.h"
+#include "mem.h"
+
+// The landscape is held in a quadtree of 8 x 8 leaves whose nodes are hash-consed, so that equal
+// squares anywhere in space or time are one node, and the centre of each node advanced by a power of
+// two steps is memoised, so that a square seen before is never advanced again. The boundaries are
+// planes of the leaves: the fixed columns are dead walls, and the periodic rows come from three
+// copies of the landscape stacked down the rows, whose first and last rows leave out their neighbour
+// across the seam. The outer copies only need to be as deep as the steps of a jump, up to L, after
+// which the universe is rebuilt from the middle copy. The live cells are only known at the end of a
+// jump, so ser_hash_process replays a jump that leaves the termination thresholds with the fused kernel.
+
+// Quadrants of a node.
+#define NW 0
+#define NE 1
+#define SW 2
+#define SE 3
+
+// Row r of a plane of a leaf, and the four cells of it starting at column c.
+#define LEAF_ROW(word, r) ((uint32_t) ((word) >> (HASH_LEAF_SIZE * (r))) & 0xff)
+#define LEAF_HALF_ROW(word, r, c) ((uint32_t) ((word) >> (HASH_LEAF_SIZE * (r) + (c))) & 0xf)
+
+// Take a node from the current block, starting a new block when it is used up.
+static hash_node *allocate_node(hash_str *hash) {
+    if (hash->nchunks == 0 || hash->chunk_used == HASH_CHUNK) {
+        if (hash->nchunks == hash->maxchunks) {
+            hash->maxchunks = hash->maxchunks ? 2 * hash->maxchunks : 64;
+            hash->chunks = (hash_node**) realloc(hash->chunks, hash->maxchunks * sizeof(hash_node*));
+            if (hash->chunks == NULL) {
+                handle_allocation_failure();
+            }
+        }
+        hash->chunks[hash->nchunks] = (hash_node*) malloc(HASH_CHUNK * sizeof(hash_node));
+        if (hash->chunks[hash->nchunks] == NULL) {
+            handle_allocation_failure();
+        }
+        hash->nchunks++;
+        hash->chunk_used = 0;
+    }
+    return &hash->chunks[hash->nchunks - 1][hash->chunk_used++];
+}
+
+// Mix the four words of a square, the addresses of its quadrants or the planes of a leaf, into a bucket index.
+static size_t hash_square(const uint64_t key[4], size_t nbuckets) {
+    uint64_t h = key[0];
+    h = h * 0x9e3779b97f4a7c15ULL + key[1];
+    h = h * 0x9e3779b97f4a7c15ULL + key[2];
+    h = h * 0x9e3779b97f4a7c15ULL + key[3];
+    h ^= h >> 29;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 32;
+    return (size_t) h & (nbuckets - 1);
+}
+
+// The four words a node is looked up by.
+static void square_key(const hash_node *node, uint64_t key[4]) {
+    if (node->level == HASH_LEAF) {
+        memcpy(key, node->square.bits, 4 * sizeof(uint64_t));
+    } else {
+        for (int q = 0; q < 4; q++) {
+            key[q] = (uint64_t) (uintptr_t) node->square.child[q];
+        }
+    }
+}
+
+// Double the buckets of the node table and move the nodes over.
+static void grow_buckets(hash_str *hash) {
+    size_t nbuckets = 2 * hash->nbuckets;
+    hash_node **buckets = (hash_node**) calloc(nbuckets, sizeof(hash_node*));
+    if (buckets == NULL) {
+        handle_allocation_failure();
+    }
+    for (size_t b = 0; b < hash->nbuckets; b++) {
+        hash_node *node = hash->buckets[b];
+        while (node != NULL) {
+            hash_node *next = node->chain;
+            uint64_t key[4];
+            square_key(node, key);
+            size_t index = hash_square(key, nbuckets);
+            node->chain = buckets[index];
+            buckets[index] = node;
+            node = next;
+        }
+    }
+    free(hash->buckets);
+    hash->buckets = buckets;
+    hash->nbuckets = nbuckets;
+}
+
+// Return the canonical node of the given level and words, creating it the first time it is seen.
+static hash_node *intern(hash_str *hash, int level, const uint64_t key[4]) {
+    size_t index = hash_square(key, hash->nbuckets);
+    for (hash_node *node = hash->buckets[index]; node != NULL; node = node->chain) {
+        if (node->level == level && memcmp(node->square.bits, key, 4 * sizeof(uint64_t)) == 0) {
+            return node;
+        }
+    }
+    hash_node *node = allocate_node(hash);
+    if (level == HASH_LEAF) {
+        memcpy(node->square.bits, key, 4 * sizeof(uint64_t));
+    } else {
+        for (int q = 0; q < 4; q++) {
+            node->square.child[q] = (hash_node*) (uintptr_t) key[q];
+        }
+    }
+    node->result = NULL;
+    node->level = level;
+    node->chain = hash->buckets[index];
+    hash->buckets[index] = node;
+    if (++hash->nodes > hash->nbuckets) {
+        grow_buckets(hash);
+    }
+    return node;
+}
+
+// Return the node made of four quadrants.
+static hash_node *join(hash_str *hash, hash_node *nw, hash_node *ne, hash_node *sw, hash_node *se) {
+    uint64_t key[4] = {(uint64_t) (uintptr_t) nw, (uint64_t) (uintptr_t) ne, (uint64_t) (uintptr_t) sw, (uint64_t) (uintptr_t) se};
+    return intern(hash, nw->level + 1, key);
+}
+
+// Return the square of the size of the four nodes at the centre of the square they make up: the
+// south-east, south-west, north-east and north-west quadrants of nw, ne, sw and se.
+static hash_node *centre(hash_str *hash, hash_node *nw, hash_node *ne, hash_node *sw, hash_node *se) {
+    if (nw->level > HASH_LEAF) {
+        return join(hash, nw->square.child[SE], ne->square.child[SW], sw->square.child[NE], se->square.child[NW]);
+    }
+    uint64_t key[4];
+    int half = HASH_LEAF_SIZE / 2;
+    for (int p = 0; p < 4; p++) {
+        key[p] = 0;
+        for (int r = 0; r < half; r++) {
+            uint64_t top = LEAF_HALF_ROW(nw->square.bits[p], r + half, half) | (LEAF_HALF_ROW(ne->square.bits[p], r + half, 0) << half);
+            uint64_t bottom = LEAF_HALF_ROW(sw->square.bits[p], r, half) | (LEAF_HALF_ROW(se->square.bits[p], r, 0) << half);
+            key[p] |= (top << (HASH_LEAF_SIZE * r)) | (bottom << (HASH_LEAF_SIZE * (r + half)));
+        }
+    }
+    return intern(hash, HASH_LEAF, key);
+}
+
+// Empty the node and memo tables and rebuild the dead square of every level.
+static void reset_tables(hash_str *hash) {
+    uint64_t dead[4] = {0, 0, 0, 0};
+
+    for (int c = 0; c < hash->nchunks; c++) {
+        free(hash->chunks[c]);
+    }
+    hash->nchunks = 0;
+    hash->chunk_used = 0;
+    memset(hash->buckets, 0, hash->nbuckets * sizeof(hash_node*));
+    hash->nodes = 0;
+    memset(hash->memo, 0, hash->nmemo * sizeof(hash_memo));
+    hash->memo_used = 0;
+    hash->empty[HASH_LEAF] = intern(hash, HASH_LEAF, dead);
+    for (int k = HASH_LEAF + 1; k <= hash->level + 1; k++) {
+        hash_node *e = hash->empty[k - 1];
+        hash->empty[k] = join(hash, e, e, e, e);
+    }
+}
+
+// Slot of the memo table for a node and jump, empty if the result is not known yet.
+static hash_memo *find_memo(hash_str *hash, hash_node *node, int jump) {
+    uint64_t h = ((uint64_t) (uintptr_t) node + jump) * 0x9e3779b97f4a7c15ULL;
+    size_t index = (size_t) (h ^ (h >> 32)) & (hash->nmemo - 1);
+    while (hash->memo[index].node != NULL && (hash->memo[index].node != node || hash->memo[index].jump != jump)) {
+        index = (index + 1) & (hash->nmemo - 1);
+    }
+    return &hash->memo[index];
+}
+
+// Record the result of a node advanced 2^jump steps, doubling the memo table when it is half full.
+static void insert_memo(hash_str *hash, hash_node *node, int jump, hash_node *result) {
+    if (2 * (hash->memo_used + 1) > hash->nmemo) {
+        hash_memo *old = hash->memo;
+        size_t nold = hash->nmemo;
+        hash->nmemo *= 2;
+        hash->memo = (hash_memo*) calloc(hash->nmemo, sizeof(hash_memo));
+        if (hash->memo == NULL) {
+            handle_allocation_failure();
+        }
+        for (size_t m = 0; m < nold; m++) {
+            if (old[m].node != NULL) {
+                *find_memo(hash, old[m].node, old[m].jump) = old[m];
+            }
+        }
+        free(old);
+    }
+    hash_memo *slot = find_memo(hash, node, jump);
+    slot->node = node;
+    slot->jump = jump;
+    slot->result = result;
+    hash->memo_used++;
+}
+
+// Evaluate the 5-point rule for a row of cells at once, as the bit-packed engine does: the inputs
+// are summed with bit-sliced full adders and the sum selects the next state through a tree of
+// multiplexers.
+static inline uint32_t next_row(uint32_t up, uint32_t centre, uint32_t down, uint32_t left, uint32_t right, const uint32_t states[6]) {
+    uint32_t sum_a = up ^ centre ^ down;
+    uint32_t carry_a = (up & centre) | (down & (up ^ centre));
+    uint32_t sum_b = left ^ right;
+    uint32_t carry_b = left & right;
+
+    uint32_t s0 = sum_a ^ sum_b;
+    uint32_t carry_c = sum_a & sum_b;
+
+    uint32_t s1 = carry_a ^ carry_b ^ carry_c;
+    uint32_t s2 = (carry_a & carry_b) | (carry_c & (carry_a ^ carry_b));
+
+    uint32_t below_two = states[0] ^ (s0 & (states[0] ^ states[1]));
+    uint32_t two_three = states[2] ^ (s0 & (states[2] ^ states[3]));
+    uint32_t four_five = states[4] ^ (s0 & (states[4] ^ states[5]));
+    uint32_t below_four = below_two ^ (s1 & (below_two ^ two_three));
+    return below_four ^ (s2 & (below_four ^ four_five));
+}
+
+// Advance the centre 8 x 8 cells of a node of four leaves by 1, 2 or 4 steps directly, one row of
+// 16 cells per word. Each step leaves the outer ring of the rows wrong, which only reaches the centre
+// after 4 steps. The walls stay dead, and the cells on the seam outside the periodic band leave out
+// their neighbour across it.
+static hash_node *step_leaves(hash_str *hash, hash_node *node, int steps) {
+    int size = 2 * HASH_LEAF_SIZE;
+    uint32_t planes[4][2 * HASH_LEAF_SIZE];
+    uint32_t next[2 * HASH_LEAF_SIZE];
+
+    for (int r = 0; r < size; r++) {
+        int q = (r < HASH_LEAF_SIZE) ? NW : SW;
+        for (int p = 0; p < 4; p++) {
+            planes[p][r] = LEAF_ROW(node->square.child[q]->square.bits[p], r % HASH_LEAF_SIZE) |
+                           (LEAF_ROW(node->square.child[q + 1]->square.bits[p], r % HASH_LEAF_SIZE) << HASH_LEAF_SIZE);
+        }
+    }
+    uint32_t *live = planes[HASH_LIVE];
+    for (int s = 0; s < steps; s++) {
+        for (int r = 1; r < size - 1; r++) {
+            next[r] = next_row(live[r - 1] & ~planes[HASH_CUT_UP][r], live[r], live[r + 1] & ~planes[HASH_CUT_DOWN][r],
+                               live[r] << 1, live[r] >> 1, hash->states) & ~planes[HASH_WALL][r];
+        }
+        memcpy(&live[1], &next[1], (size - 2) * sizeof(uint32_t));
+    }
+
+    uint64_t key[4] = {0, 0, 0, 0};
+    int quarter = HASH_LEAF_SIZE / 2;
+    for (int p = 0; p < 4; p++) {
+        for (int r = 0; r < HASH_LEAF_SIZE; r++) {
+            key[p] |= (uint64_t) ((planes[p][r + quarter] >> quarter) & 0xff) << (HASH_LEAF_SIZE * r);
+        }
+    }
+    return intern(hash, HASH_LEAF, key);
+}
+
+// Return the centre half of a node of level k > HASH_LEAF advanced 2^jump steps, at most 2^(k-2).
+// The centre is assembled from the nine overlapping squares of half the size: each is advanced, and
+// for the full 2^(k-2) steps the four squares combining them are advanced again, while for shorter
+// jumps their centres are taken as they are. Full results are kept in the node and shorter ones in
+// the memo table, so each square is only ever advanced once by each jump.
+static hash_node *advance(hash_str *hash, hash_node *node, int jump) {
+    int k = node->level;
+    int full = (jump >= k - 2);
+    hash_node *result;
+
+    if (full && node->result != NULL) {
+        return node->result;
+    }
+    if (!full) {
+        hash_memo *slot = find_memo(hash, node, jump);
+        if (slot->node != NULL) {
+            return slot->result;
+        }
+    }
+
+    if (k == HASH_LEAF + 1) {
+        result = step_leaves(hash, node, 1 << (full ? k - 2 : jump));
+    } else {
+        hash_node *a = node->square.child[NW], *b = node->square.child[NE], *c = node->square.child[SW], *d = node->square.child[SE];
+        hash_node *m[3][3] = {
+            {a, join(hash, a->square.child[NE], b->square.child[NW], a->square.child[SE], b->square.child[SW]), b},
+            {join(hash, a->square.child[SW], a->square.child[SE], c->square.child[NW], c->square.child[NE]),
+             join(hash, a->square.child[SE], b->square.child[SW], c->square.child[NE], d->square.child[NW]),
+             join(hash, b->square.child[SW], b->square.child[SE], d->square.child[NW], d->square.child[NE])},
+            {c, join(hash, c->square.child[NE], d->square.child[NW], c->square.child[SE], d->square.child[SW]), d},
+        };
+        int stage = full ? k - 3 : jump;
+        hash_node *r[3][3];
+        for (int i = 0; i < 3; i++) {
+            for (int j = 0; j < 3; j++) {
+                r[i][j] = advance(hash, m[i][j], stage);
+            }
+        }
+
+        hash_node *q[2][2];
+        for (int i = 0; i < 2; i++) {
+            for (int j = 0; j < 2; j++) {
+                if (full) {
+                    q[i][j] = advance(hash, join(hash, r[i][j], r[i][j + 1], r[i + 1][j], r[i + 1][j + 1]), stage);
+                } else {
+                    q[i][j] = centre(hash, r[i][j], r[i][j + 1], r[i + 1][j], r[i + 1][j + 1]);
+                }
+            }
+        }
+        result = join(hash, q[0][0], q[0][1], q[1][0], q[1][1]);
+    }
+
+    if (full) {
+        node->result = result;
+    } else {
+        insert_memo(hash, node, jump, result);
+    }
+    return result;
+}
+
+// Planes of the leaf whose top left cell is at (row, col) of the universe. The landscape is stacked
+// three times down the rows, between two wall columns, so that its middle copy at rows L to 2L-1
+// and columns 1 to L sees the first and last rows of the copies around it across the periodic seam.
+// Only the margin rows of the outer copies next to the middle one are filled in: the copies evolve
+// wrong from their outer edges, by one row per step, so the middle copy is exact for margin steps.
+static hash_node *build_leaf(hash_str *hash, int **cell_grid, long row, long col, int L, int margin) {
+    uint64_t key[4] = {0, 0, 0, 0};
+
+    for (int r = 0; r < HASH_LEAF_SIZE && row + r < 2L * L + margin; r++) {
+        if (row + r < L - margin) {
+            continue;
+        }
+        int i = (int) ((row + r) % L);
+        for (int c = 0; c < HASH_LEAF_SIZE && col + c <= L + 1; c++) {
+            int j = (int) (col + c);
+            uint64_t bit = (uint64_t) 1 << (HASH_LEAF_SIZE * r + c);
+            if (j == 0 || j == L + 1) {
+                key[HASH_WALL] |= bit;
+                continue;
+            }
+            if (cell_grid[i + 1][j]) {
+                key[HASH_LIVE] |= bit;
+            }
+            if (j < hash->band_start || j > hash->band_end) {
+                if (i == 0) {
+                    key[HASH_CUT_UP] |= bit;
+                } else if (i == L - 1) {
+                    key[HASH_CUT_DOWN] |= bit;
+                }
+            }
+        }
+    }
+    return intern(hash, HASH_LEAF, key);
+}
+
+// Build the node of the given level whose top left cell is at (row, col) of the universe, with the
+// given margin of rows around the middle copy of the landscape.
+static hash_node *build(hash_str *hash, int **cell_grid, int level, long row, long col, int L, int margin) {
+    long half = 1L << (level - 1);
+    if (row >= 2L * L + margin || row + 2 * half <= L - margin || col > L + 1) {
+        return hash->empty[level];
+    }
+    if (level == HASH_LEAF) {
+        return build_leaf(hash, cell_grid, row, col, L, margin);
+    }
+    return join(hash, build(hash, cell_grid, level - 1, row, col, L, margin), build(hash, cell_grid, level - 1, row, col + half, L, margin),
+                build(hash, cell_grid, level - 1, row + half, col, L, margin), build(hash, cell_grid, level - 1, row + half, col + half, L, margin));
+}
+
+// Copy the cells of the landscape out of a node whose top left cell is at (row, col) of the
+// landscape, and return the live cells.
+static int extract(hash_node *node, int **cell_grid, long row, long col, int L) {
+    long size = 1L << node->level;
+    int live_cells = 0;
+    if (row >= L || col >= L || row + size <= 0 || col + size <= 0) {
+        return 0;
+    }
+    if (node->level == HASH_LEAF) {
+        for (int r = 0; r < HASH_LEAF_SIZE; r++) {
+            for (int c = 0; c < HASH_LEAF_SIZE; c++) {
+                if (row + r >= 0 && row + r < L && col + c >= 0 && col + c < L) {
+                    int cell = (node->square.bits[HASH_LIVE] >> (HASH_LEAF_SIZE * r + c)) & 1;
+                    cell_grid[row + r + 1][col + c + 1] = cell;
+                    live_cells += cell;
+                }
+            }
+        }
+        return live_cells;
+    }
+    long half = size / 2;
+    return extract(node->square.child[NW], cell_grid, row, col, L) + extract(node->square.child[NE], cell_grid, row, col + half, L) +
+           extract(node->square.child[SW], cell_grid, row + half, col, L) + extract(node->square.child[SE], cell_grid, row + half, col + half, L);
+}
+
+// Place a node at the centre of one twice its size, with dead cells around it.
+static hash_node *expand(hash_str *hash, hash_node *node) {
+    hash_node *e = hash->empty[node->level - 1];
+    return join(hash, join(hash, e, e, e, node->square.child[NW]), join(hash, e, e, node->square.child[NE], e),
+                join(hash, e, node->square.child[SW], e, e), join(hash, node->square.child[SE], e, e, e));
+}
+
+// Pick the smallest universe that holds the three copies of the landscape and set up empty tables.
+void hash_init(hash_str *hash, int periodic_boundary_start, int periodic_boundary_end, master_str *master) {
+    memset(hash, 0, sizeof(*hash));
+    hash->level = HASH_LEAF + 1;
+    while ((1L << hash->level) < 3L * master->params.landscape) {
+        hash->level++;
+    }
+    hash->band_start = periodic_boundary_start;
+    hash->band_end = periodic_boundary_end;
+    for (int s = 0; s < 6; s++) {
+        hash->states[s] = master->params.rule.alive[s] ? ~(uint32_t) 0 : 0;
+    }
+    hash->nbuckets = 1 << 16;
+    hash->buckets = (hash_node**) calloc(hash->nbuckets, sizeof(hash_node*));
+    hash->nmemo = 1 << 12;
+    hash->memo = (hash_memo*) calloc(hash->nmemo, sizeof(hash_memo));
+    hash->empty = (hash_node**) malloc((hash->level + 2) * sizeof(hash_node*));
+    if (hash->buckets == NULL || hash->memo == NULL || hash->empty == NULL) {
+        handle_allocation_failure();
+    }
+    reset_tables(hash);
+}
+
+// Advance the landscape by up to L steps at a time from a universe built out of the cell grid with
+// margins as deep as the steps. The steps are taken in jumps of powers of two, the longest first,
+// each advancing the whole universe, placed at the centre of a root twice its size, and only the
+// landscape of the last jump is copied back. The tables are kept from one call to the next, so that
+// the squares seen before are not advanced again, unless they have grown past HASH_MAXNODES nodes.
+int hash_advance(hash_str *hash, int **cell_grid, int steps, master_str *master) {
+    int L = master->params.landscape;
+    int live_cells = 0;
+
+    while (steps > 0) {
+        int chunk = (steps < L) ? steps : L;
+        if (hash->nodes > HASH_MAXNODES) {
+            reset_tables(hash);
+            hash->clears++;
+        }
+        hash_node *universe = build(hash, cell_grid, hash->level, 0, 0, L, chunk);
+        for (int done = 0; done < chunk; ) {
+            int jump = 0;
+            while ((2 << jump) <= chunk - done) {
+                jump++;
+            }
+            universe = advance(hash, expand(hash, universe), jump);
+            done += 1 << jump;
+            hash->jumps++;
+            if ((1 << jump) > hash->longest) {
+                hash->longest = 1 << jump;
+            }
+        }
+        live_cells = extract(universe, cell_grid, -L, -1, L);
+        steps -= chunk;
+    }
+    return live_cells;
+}
+
+// Free the node blocks and the tables.
+void hash_free(hash_str *hash) {
+    for (int c = 0; c < hash->nchunks; c++) {
+        free(hash->chunks[c]);
+    }
+    free(hash->chunks);
+    free(hash->buckets);
+    free(hash->memo);
+    free(hash->empty);
+}
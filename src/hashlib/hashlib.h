@@ -0,0 +1,33 @@
+#ifndef HASHLIB_H
+#define HASHLIB_H
+
+#include "structs.h"  // Including necessary structures like master_str
+
+// Level of the leaves, squares of 8 x 8 cells held as one word per plane, cell (r, c) being bit 8r + c
+#define HASH_LEAF 3
+#define HASH_LEAF_SIZE 8
+
+// Planes of a leaf: the live cells and the kind of boundary each cell sits on. A cell of the first
+// row outside the periodic band does not see the last row across the seam, and the other way
+// round; the walls are the fixed dead columns on either side of the landscape.
+#define HASH_LIVE 0
+#define HASH_CUT_UP 1
+#define HASH_CUT_DOWN 2
+#define HASH_WALL 3
+
+// Nodes above which the tables are emptied before the universe is next built, to bound their memory
+#define HASH_MAXNODES (1 << 22)
+
+// Nodes per block of the node allocator
+#define HASH_CHUNK 65536
+
+// Sets up empty tables for the landscape and the periodic boundary band of the run
+void hash_init(hash_str *hash, int periodic_boundary_start, int periodic_boundary_end, master_str *master);
+
+// Advances the interior of the padded cell grid by steps generations and returns its live cells
+int hash_advance(hash_str *hash, int **cell_grid, int steps, master_str *master);
+
+// Frees the nodes and tables
+void hash_free(hash_str *hash);
+
+#endif // HASHLIB_H
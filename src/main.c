@@ -8,6 +8,7 @@
 #include "mplib.h"
 #include "mem.h"
 #include "wraplib.h"
+#include "benchlib.h"
 
 int main(int argc, char *argv[]) {
 
@@ -25,6 +26,14 @@ int main(int argc, char *argv[]) {
         return 0;
     }
 
+    // Take the landscape and the step to resume from out of the checkpoint when restarting
+    if (load_checkpoint_header(&master) == FAILED) {
+
+        mpstop(); // Stop the MPI environment
+
+        return 0;
+    }
+
     // Compute dimensions for the simulation, exit if unsuccessful
     if (compute_dimensions(&master) == FAILED) {
 
@@ -36,21 +45,28 @@ int main(int argc, char *argv[]) {
     // Create arrays for cell data and their neighbors
     int **cell_grid = create_cell_array(&master);
     int **neighbor_grid = create_neighbours_array(&master);
-    int **global_cell_grid = create_global_array(&master);
-    int **reduction_cell_grid = create_reduction_array(&master);
+    int **global_cell_grid = create_global_array(&master);  // NULL except on the root
     int **local_cell_grid = create_local_cell_array(&master);
 
-    // Initialize and distribute the workload across the processors
-    initialise_and_distribute(&master, cell_grid, global_cell_grid, local_cell_grid);
+    if (master.params.bench > 0) {
+        // Time the initialisation, the steps and the output over repeated trials
+        benchmark(&master, &cell_grid, &neighbor_grid, global_cell_grid, local_cell_grid);
+    } else {
+        // Initialize and distribute the workload across the processors
+        initialise_and_distribute(&master, cell_grid, global_cell_grid, local_cell_grid);
 
-    // Process the cells based on the current simulation parameters
-    process(&master, cell_grid, neighbor_grid);
+        // Report the memory held by each process, which is O(L^2/P) except on the root
+        report_memory(&master);
 
-    // Gather data from all nodes and write to output
-    gather_write_data(&master, local_cell_grid, reduction_cell_grid, global_cell_grid, cell_grid);
+        // Process the cells based on the current simulation parameters
+        process(&master, &cell_grid, &neighbor_grid);
+
+        // Gather data from all nodes and write to output
+        gather_write_data(&master, local_cell_grid, global_cell_grid, cell_grid);
+    }
 
     // Clean up resources and stop communication
-    clean_buffers_stop_comm(&master, cell_grid, neighbor_grid, global_cell_grid, local_cell_grid, reduction_cell_grid);
+    clean_buffers_stop_comm(&master, cell_grid, neighbor_grid, global_cell_grid, local_cell_grid);
 
     // Exit the program
     return 0;
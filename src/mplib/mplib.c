@@ -2,7 +2,9 @@
 #include <stdlib.h>
 #include <mpi.h>
 #include <string.h>
+#include <stdint.h>
 #include "structs.h"
+#include "mem.h"
 
 
 #define NDIMS 2   
@@ -11,7 +13,9 @@
 
 // Initialize the MPI environment and set up the communication structure.
 void mpstart(comm_str *comm) { 
-    MPI_Init(NULL, NULL); // Initialize MPI environment.
+    int provided;
+    // Only the main thread of a process calls MPI, between the threaded row loops.
+    MPI_Init_thread(NULL, NULL, MPI_THREAD_FUNNELED, &provided);
     comm->comm = MPI_COMM_WORLD; // Set MPI communicator to the global communicator.
     MPI_Comm_rank(comm->comm, &comm->rank); // Get the rank of the current process.
     MPI_Comm_size(comm->comm, &comm->size); // Get the total number of processes.
@@ -22,6 +26,49 @@ void mpstop(void) {
     MPI_Finalize(); // Clean up all MPI state.
 }
 
+// Find the shared-memory node of this process: the world rank of the lowest process on it, which
+// identifies it, its index counting the nodes in the order of their lowest ranks, the rank of this
+// process on it and the number of processes on it. Returns the number of nodes.
+static int find_node(int *leader, int *node, int *local_rank, int *node_size) {
+    int world_rank, world_size, first, nodes;
+    MPI_Comm node_comm;
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &world_rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &world_size);
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, world_rank, MPI_INFO_NULL, &node_comm);
+    MPI_Comm_rank(node_comm, local_rank);
+    MPI_Comm_size(node_comm, node_size);
+    *leader = world_rank;
+    MPI_Bcast(leader, 1, MPI_INT, 0, node_comm);
+    MPI_Comm_free(&node_comm);
+
+    int *firsts = (int*) malloc(world_size * sizeof(int));
+    if (firsts == NULL) {
+        handle_allocation_failure();
+    }
+    first = (*local_rank == 0);
+    MPI_Allgather(&first, 1, MPI_INT, firsts, 1, MPI_INT, MPI_COMM_WORLD);
+    nodes = 0;
+    *node = 0;
+    for (int r = 0; r < world_size; r++) {
+        nodes += firsts[r];
+        *node += (firsts[r] && r < *leader);
+    }
+    free(firsts);
+    return nodes;
+}
+
+// Take the rank and coordinates of this process in the grid, which reordering may have changed,
+// and its neighbours.
+static void locate_in_grid(comm_str *comm, cart_str *cart) {
+    MPI_Comm_rank(cart->comm2d, &comm->rank); // Rank in the grid, also the root's for rank 0.
+    MPI_Cart_coords(cart->comm2d, comm->rank, NDIMS, cart->coords); // Get Cartesian coordinates of the current process.
+
+    // Determine neighboring processes in the grid.
+    MPI_Cart_shift(cart->comm2d, HORIZONTAL, VERTICAL, &cart->up.val, &cart->down.val); // Neighbors in the first dimension.
+    MPI_Cart_shift(cart->comm2d, VERTICAL, VERTICAL, &cart->left.val, &cart->right.val); // Neighbors in the second dimension.
+}
+
 // Setup a Cartesian topology for the MPI processes.
 void setup_cartesian_topology(comm_str *comm, cart_str *cart) {
     // Initialize grid dimensions and periodicity.
@@ -30,33 +77,429 @@ void setup_cartesian_topology(comm_str *comm, cart_str *cart) {
     cart->period[0] = 1; // Periodic in the first dimension.
     cart->period[1] = 0; // Non-periodic in the second dimension.
     cart->reorder = 0; // Disable reordering of processes within the grid.
+    cart->node_dims[0] = 0;
+    cart->node_dims[1] = 0;
     
     // Create a Cartesian grid communicator based on dimensions and periodicity.
     MPI_Dims_create(comm->size, NDIMS, cart->dims); // Automatically set the dimensions.
     MPI_Cart_create(comm->comm, NDIMS, cart->dims, cart->period, cart->reorder, &cart->comm2d); // Create the Cartesian topology.
-    MPI_Cart_coords(cart->comm2d, comm->rank, NDIMS, cart->coords); // Get Cartesian coordinates of the current process.
+    locate_in_grid(comm, cart);
+}
 
-    // Determine neighboring processes in the grid.
-    MPI_Cart_shift(cart->comm2d, HORIZONTAL, VERTICAL, &cart->up.val, &cart->down.val); // Neighbors in the first dimension.
-    MPI_Cart_shift(cart->comm2d, VERTICAL, VERTICAL, &cart->left.val, &cart->right.val); // Neighbors in the second dimension.
+// Choose the process grid, and the block of it that each node holds, which send the fewest halo
+// cells between nodes, then the fewest in total, preferring more rows than columns on a tie. Every
+// boundary between blocks carries a whole row or column of the landscape each way: down the
+// periodic rows there are as many boundaries as blocks, unless there is a single block, whose
+// halos wrap around onto itself, and across the columns one fewer. The halo cells in total follow
+// with blocks of one process.
+static void choose_grid(int size, int node_size, int dims[NDIMS], int node_dims[NDIMS]) {
+    int best_between = -1, best_total = -1, best_wide = -1;
+
+    for (int rows = 1; rows <= size; rows++) {
+        if (size % rows != 0) {
+            continue;
+        }
+        int cols = size / rows;
+        for (int block_rows = 1; block_rows <= node_size; block_rows++) {
+            int block_cols = node_size / block_rows;
+            if (node_size % block_rows != 0 || rows % block_rows != 0 || cols % block_cols != 0) {
+                continue;
+            }
+            int between = ((rows / block_rows > 1) ? rows / block_rows : 0) + cols / block_cols - 1;
+            int total = ((rows > 1) ? rows : 0) + cols - 1;
+            int wide = (rows < cols);
+            if (best_between < 0 || between < best_between ||
+                    (between == best_between && (total < best_total || (total == best_total && wide < best_wide)))) {
+                best_between = between;
+                best_total = total;
+                best_wide = wide;
+                dims[0] = rows;
+                dims[1] = cols;
+                node_dims[0] = block_rows;
+                node_dims[1] = block_cols;
+            }
+        }
+    }
+}
+
+// Replace the Cartesian topology with one whose process grid sends the fewest halo cells between
+// nodes. When every node runs the same number of processes, the ranks of each node are placed on a
+// block of the grid, nodes in order along the rows of blocks, by splitting the world in the order
+// of the grid; otherwise the grid only minimises the halo cells in total and MPI may reorder the ranks.
+void setup_node_aware_topology(comm_str *comm, cart_str *cart) {
+    int leader, node, local_rank, node_size, smallest, largest;
+
+    find_node(&leader, &node, &local_rank, &node_size);
+    MPI_Allreduce(&node_size, &smallest, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    MPI_Allreduce(&node_size, &largest, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+
+    MPI_Comm_free(&cart->comm2d);
+    cart->reorder = 1;
+    if (smallest == largest) {
+        MPI_Comm placed;
+        choose_grid(comm->size, node_size, cart->dims, cart->node_dims);
+        int blocks = cart->dims[1] / cart->node_dims[1];
+        int row = (node / blocks) * cart->node_dims[0] + local_rank / cart->node_dims[1];
+        int col = (node % blocks) * cart->node_dims[1] + local_rank % cart->node_dims[1];
+        MPI_Comm_split(MPI_COMM_WORLD, 0, row * cart->dims[1] + col, &placed);
+        MPI_Cart_create(placed, NDIMS, cart->dims, cart->period, 0, &cart->comm2d);
+        MPI_Comm_free(&placed);
+    } else {
+        choose_grid(comm->size, 1, cart->dims, cart->node_dims);
+        cart->node_dims[0] = 0;
+        cart->node_dims[1] = 0;
+        MPI_Cart_create(MPI_COMM_WORLD, NDIMS, cart->dims, cart->period, cart->reorder, &cart->comm2d);
+    }
+    locate_in_grid(comm, cart);
 }
 
-// Reduce the local count of cells to a global count using MPI_Reduce.
-void mpi_reduce_localncell(cart_str cart, int local_live_cells, int *total_live_cells) {
+// Print the process grid and the nodes it runs on, and estimate the halo bytes sent per step in
+// total, between nodes and by the busiest process, from the cells of the edge rows and columns of
+// each tile and the bytes per cell of the engine. Deep halos send k rows every k steps, about as
+// many per step.
+void report_topology(master_str *master) {
+    cart_str cart = master->cart;
+    int leader, node, local_rank, node_size;
+    int neighbours[4] = {cart.up.val, cart.down.val, cart.left.val, cart.right.val};
+    int cells[4] = {master->dimensions.cols, master->dimensions.cols, master->dimensions.rows, master->dimensions.rows};
+    double cell_bytes = (master->params.engine == bit_engine) ? 0.125 : (master->params.engine == simd_engine) ? 1.0 : sizeof(int);
+    double local[3] = {0.0, 0.0, 0.0};
+    double total[3];
+
+    int nodes = find_node(&leader, &node, &local_rank, &node_size);
+    int *leaders = (int*) malloc(master->comm.size * sizeof(int));
+    if (leaders == NULL) {
+        handle_allocation_failure();
+    }
+    MPI_Allgather(&leader, 1, MPI_INT, leaders, 1, MPI_INT, cart.comm2d);
+    for (int d = 0; d < 4; d++) {
+        if (neighbours[d] != MPI_PROC_NULL) {
+            local[0] += cells[d] * cell_bytes;
+            local[1] += (leaders[neighbours[d]] != leader) ? cells[d] * cell_bytes : 0.0;
+        }
+    }
+    free(leaders);
+    MPI_Reduce(local, total, 2, MPI_DOUBLE, MPI_SUM, 0, cart.comm2d);
+    MPI_Reduce(&local[0], &total[2], 1, MPI_DOUBLE, MPI_MAX, 0, cart.comm2d);
+
+    if (master->comm.rank == 0) {
+        printf("automaton: process grid %d x %d on %d node(s)", cart.dims[0], cart.dims[1], nodes);
+        if (cart.node_dims[0] > 0) {
+            printf(", %d x %d per node", cart.node_dims[0], cart.node_dims[1]);
+        }
+        printf("%s\n", cart.reorder ? ", reordered" : "");
+        printf("automaton: halo of %.0f bytes per step, %.0f between nodes, at most %.0f per process\n", total[0], total[1], total[2]);
+    }
+}
+
+// Reduce the local count of cells to a global count on every process using MPI_Allreduce.
+int mpi_allreduce_localncell(cart_str cart, int local_live_cells) {
+    int total_live_cells;
     // Aggregate local cell counts across all processes.
-    MPI_Reduce(&local_live_cells, total_live_cells, 1, MPI_INT, MPI_SUM, 0, cart.comm2d);
+    MPI_Allreduce(&local_live_cells, &total_live_cells, 1, MPI_INT, MPI_SUM, cart.comm2d);
+    return total_live_cells;
+}
+
+// Split a landscape into nblocks blocks whose sizes differ by at most one, the larger ones first,
+// and return the first index and the size of the given block.
+void block_decomposition(int landscape, int nblocks, int block, int *first, int *size) {
+    int base = landscape / nblocks;
+    int remainder = landscape % nblocks;
+
+    *size = base + (block < remainder ? 1 : 0);
+    *first = block * base + (block < remainder ? block : remainder);
+}
+
+// Create the datatype selecting the tile of the given rank inside the global landscape.
+static void create_tile_type(MPI_Datatype *tile_type, int rank, cart_str cart, master_str *master) {
+    int coords[NDIMS];
+    int sizes[NDIMS] = {master->params.landscape, master->params.landscape};
+    int subsizes[NDIMS];
+    int starts[NDIMS];
+
+    MPI_Cart_coords(cart.comm2d, rank, NDIMS, coords);
+    for (int d = 0; d < NDIMS; d++) {
+        block_decomposition(master->params.landscape, cart.dims[d], coords[d], &starts[d], &subsizes[d]);
+    }
+
+    MPI_Type_create_subarray(NDIMS, sizes, subsizes, starts, MPI_ORDER_C, MPI_INT, tile_type);
+    MPI_Type_commit(tile_type); // Commit the type to use it for MPI operations.
+}
+
+// Move every tile between the global landscape on the root and the local grids, each tile exactly
+// once. Tiles may differ in size, so the root describes each one with its own subarray type through
+// MPI_Alltoallw, where every process only exchanges with the root.
+static void transfer_tiles(cart_str cart, int **local_cell_grid, int **global_cell_grid, int scatter, master_str *master) {
+    int size = master->comm.size;
+    int *local_counts = (int*) calloc(size, sizeof(int));
+    int *root_counts = (int*) calloc(size, sizeof(int));
+    int *displs = (int*) calloc(size, sizeof(int));
+    MPI_Datatype *local_types = (MPI_Datatype*) malloc(size * sizeof(MPI_Datatype));
+    MPI_Datatype *root_types = (MPI_Datatype*) malloc(size * sizeof(MPI_Datatype));
+    void *global = (master->comm.rank == 0) ? &global_cell_grid[0][0] : NULL;
+
+    if (local_counts == NULL || root_counts == NULL || displs == NULL || local_types == NULL || root_types == NULL) {
+        handle_allocation_failure();
+    }
+
+    for (int rank = 0; rank < size; rank++) {
+        local_types[rank] = MPI_INT;
+        root_types[rank] = MPI_INT;
+    }
+    local_counts[0] = master->dimensions.rows * master->dimensions.cols;
+    if (master->comm.rank == 0) {
+        for (int rank = 0; rank < size; rank++) {
+            create_tile_type(&root_types[rank], rank, cart, master);
+            root_counts[rank] = 1;
+        }
+    }
+
+    if (scatter) {
+        MPI_Alltoallw(global, root_counts, displs, root_types, &local_cell_grid[0][0], local_counts, displs, local_types, cart.comm2d);
+    } else {
+        MPI_Alltoallw(&local_cell_grid[0][0], local_counts, displs, local_types, global, root_counts, displs, root_types, cart.comm2d);
+    }
+
+    if (master->comm.rank == 0) {
+        for (int rank = 0; rank < size; rank++) {
+            MPI_Type_free(&root_types[rank]);
+        }
+    }
+    free(local_counts);
+    free(root_counts);
+    free(displs);
+    free(local_types);
+    free(root_types);
+}
+
+// Send every process its tile of the global landscape held by the root. Each tile is transferred
+// exactly once, so that only the root ever holds the whole landscape.
+void mpscatter_tiles(cart_str cart, int **global_cell_grid, int **local_cell_grid, master_str *master) {
+    transfer_tiles(cart, local_cell_grid, global_cell_grid, 1, master);
+}
+
+// Collect the tile of every process into the global landscape on the root, each tile transferred exactly once.
+void mpgather_tiles(cart_str cart, int **local_cell_grid, int **global_cell_grid, master_str *master) {
+    transfer_tiles(cart, local_cell_grid, global_cell_grid, 0, master);
+}
+
+// Return whether every process can write its own part of the binary image. Image rows are packed
+// eight cells to a byte, so a byte may straddle two tiles; each process writes the bytes starting
+// in its tile and completes the last one with the first rows of the next tile, which needs tiles
+// of at least eight rows.
+int mpwrite_supported(master_str *master) {
+    return master->cart.dims[0] == 1 || master->params.landscape / master->cart.dims[0] >= 8;  // Smallest tile
+}
+
+// Complete the image write pending in image, if any, and close its file.
+void mpwrite_cells_wait(image_str *image) {
+    if (image->pending) {
+        MPI_Wait(&image->request, MPI_STATUS_IGNORE);
+        MPI_File_close(&image->fh);
+        image->pending = 0;
+    }
+}
+
+// Start writing the tiles, cell (i,j) of a tile being cell_grid[halo+i][halo+j], as one binary (P4)
+// PBM image with cell [0][0] in the bottom-left corner, as writecelldynamic does. Global column j
+// is image row L-1-j and global row i is pixel i of that row. Rank 0 writes the header and every
+// rank packs its block of the image into image->block, then writes it collectively through a
+// subarray file view with a non-blocking MPI_File_iwrite_all, so the grid can be updated while
+// the write is in flight. A write still pending in image is completed first.
+void mpwrite_cells_start(char *cellfile, int **cell_grid, int halo, image_str *image, cart_str cart, master_str *master) {
+    int landscape = master->params.landscape;
+    int rows = master->dimensions.rows;
+    int cols = master->dimensions.cols;
+    int first_row = master->dimensions.first_row;
+    int last_process = (cart.coords[0] == cart.dims[0] - 1);
+    int rowbytes = (landscape + 7) / 8;
+    int first_byte = (first_row + 7) / 8;
+    int end_byte = last_process ? rowbytes : (first_row + rows + 7) / 8;
+    int nbytes = end_byte - first_byte;
+    int send_rows = (8 - first_row % 8) % 8;                          // Needed by the previous tile
+    int recv_rows = last_process ? 0 : (8 - (first_row + rows) % 8) % 8;  // Needed from the next tile
+    int previous = (cart.coords[0] == 0) ? MPI_PROC_NULL : cart.up.val;
+    int next = last_process ? MPI_PROC_NULL : cart.down.val;
+    char header[64];
+    int header_size = sprintf(header, "P4\n# Written by mpwrite_cells\n%d %d\n", landscape, landscape);
+    int *first_rows = (int*) malloc(((size_t) send_rows * cols + 1) * sizeof(int));
+    int *next_rows = (int*) malloc(((size_t) recv_rows * cols + 1) * sizeof(int));
+    if (first_rows == NULL || next_rows == NULL) {
+        handle_allocation_failure();
+    }
+
+    mpwrite_cells_wait(image);
+
+    if (image->block == NULL) {
+        int sizes[NDIMS] = {landscape, rowbytes};
+        int subsizes[NDIMS] = {cols, nbytes};
+        int starts[NDIMS] = {landscape - master->dimensions.first_col - cols, first_byte};
+
+        image->block = (unsigned char*) malloc((size_t) cols * nbytes);
+        if (image->block == NULL) {
+            handle_allocation_failure();
+        }
+        MPI_Type_create_subarray(NDIMS, sizes, subsizes, starts, MPI_ORDER_C, MPI_BYTE, &image->type);
+        MPI_Type_commit(&image->type);
+    }
+
+    if (cart.dims[0] > 1) {
+        for (int i = 0; i < send_rows; i++) {
+            memcpy(&first_rows[i * cols], &cell_grid[halo + i][halo], cols * sizeof(int));
+        }
+        MPI_Sendrecv(first_rows, send_rows * cols, MPI_INT, previous, 7,
+                     next_rows, recv_rows * cols, MPI_INT, next, 7, cart.comm2d, MPI_STATUS_IGNORE);
+    }
+
+    // Each byte packs eight consecutive rows of a column, read row by row to stay in cache. Image
+    // row t of the block is global column first_col + cols-1-t, so the last local column comes first.
+    for (int k = 0; k < nbytes; k++) {
+        int *row[8];
+        int nrows = 0;
+
+        for (int i = (first_byte + k) * 8; i < (first_byte + k + 1) * 8 && i < landscape; i++, nrows++) {
+            int local_row = i - first_row;
+            row[nrows] = (local_row < rows) ? &cell_grid[halo + local_row][halo] : &next_rows[(local_row - rows) * cols];
+        }
+        for (int j = 0; j < cols; j++) {
+            unsigned char pixels = 0;
+            for (int b = 0; b < nrows; b++) {
+                pixels |= (unsigned char) ((row[b][j] != 1) << (7 - b));  // 1 is black in PBM
+            }
+            image->block[(size_t) (cols - 1 - j) * nbytes + k] = pixels;
+        }
+    }
+
+    MPI_File_open(cart.comm2d, cellfile, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &image->fh);
+    MPI_File_set_size(image->fh, 0);  // Truncate any previous, larger image
+    if (master->comm.rank == 0) {
+        MPI_File_write_at(image->fh, 0, header, header_size, MPI_CHAR, MPI_STATUS_IGNORE);
+    }
+    MPI_File_set_view(image->fh, header_size, MPI_BYTE, image->type, "native", MPI_INFO_NULL);
+    MPI_File_iwrite_all(image->fh, image->block, cols * nbytes, MPI_BYTE, &image->request);
+    image->pending = 1;
+
+    free(first_rows);
+    free(next_rows);
+}
+
+// Release the buffer and the datatype of image once its last write has completed.
+void mpwrite_cells_free(image_str *image) {
+    mpwrite_cells_wait(image);
+    if (image->block != NULL) {
+        MPI_Type_free(&image->type);
+        free(image->block);
+        image->block = NULL;
+    }
+}
+
+// Write the local tiles, held without halos in local_cell_grid, as one binary (P4) PBM image.
+void mpwrite_cells(char *cellfile, int **local_cell_grid, cart_str cart, master_str *master) {
+    image_str image = {0};
+
+    if (master->comm.rank == 0) {
+        printf("mpwrite_cells: writing <%s> ...\n", cellfile);
+    }
+
+    mpwrite_cells_start(cellfile, local_cell_grid, 0, &image, cart, master);
+    mpwrite_cells_free(&image);
+
+    if (master->comm.rank == 0) {
+        printf("mpwrite_cells: ... done\n");
+    }
+}
+
+// Create the file view selecting the tile of this process, one byte per cell, in the landscape of a checkpoint.
+static void create_checkpoint_view(MPI_File fh, cart_str cart, master_str *master) {
+    int sizes[NDIMS] = {master->params.landscape, master->params.landscape};
+    int subsizes[NDIMS] = {master->dimensions.rows, master->dimensions.cols};
+    int starts[NDIMS] = {master->dimensions.first_row, master->dimensions.first_col};
+    MPI_Datatype tile_type;
+
+    MPI_Type_create_subarray(NDIMS, sizes, subsizes, starts, MPI_ORDER_C, MPI_BYTE, &tile_type);
+    MPI_Type_commit(&tile_type);
+    MPI_File_set_view(fh, CHECKPOINT_OFFSET, MPI_BYTE, tile_type, "native", MPI_INFO_NULL);
+    MPI_Type_free(&tile_type);
 }
 
-// Reduce local arrays to a global array using MPI_Reduce.
-void mpi_reduce_allcell(cart_str cart, int **reduction_cell_grid, int **global_cell_grid, int size) {
-    // Sum 2D arrays from all processes into a single global 2D array on the root process.
-    MPI_Reduce(&reduction_cell_grid[0][0], &global_cell_grid[0][0], size*size, MPI_INT, MPI_SUM, 0, cart.comm2d);
+// Write the interior of cell_grid and the header to a checkpoint file with collective MPI-IO. The
+// cells are stored in the global layout of the landscape, independent of the decomposition, so the
+// file can be read back by any number of processes. Returns 0 on success.
+int mpwrite_checkpoint(char *filename, int **cell_grid, checkpoint_str *header, cart_str cart, master_str *master) {
+    int rows = master->dimensions.rows;
+    int cols = master->dimensions.cols;
+    unsigned char *tile = (unsigned char*) malloc((size_t) rows * cols);
+    MPI_File fh;
+
+    if (tile == NULL) {
+        handle_allocation_failure();
+    }
+
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            tile[(size_t) i * cols + j] = (unsigned char) cell_grid[i + 1][j + 1];
+        }
+    }
+
+    if (MPI_File_open(cart.comm2d, filename, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+        free(tile);
+        return 1;
+    }
+    if (master->comm.rank == 0) {
+        MPI_File_write_at(fh, 0, header, sizeof(checkpoint_str), MPI_BYTE, MPI_STATUS_IGNORE);
+    }
+    create_checkpoint_view(fh, cart, master);
+    MPI_File_write_all(fh, tile, rows * cols, MPI_BYTE, MPI_STATUS_IGNORE);
+    MPI_File_close(&fh);
+
+    free(tile);
+    return 0;
+}
+
+// Read the header of a checkpoint file on every process. Returns 0 on success.
+int mpread_checkpoint_header(char *filename, checkpoint_str *header, cart_str cart) {
+    MPI_File fh;
+
+    if (MPI_File_open(cart.comm2d, filename, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+        return 1;
+    }
+    MPI_File_read_at_all(fh, 0, header, sizeof(checkpoint_str), MPI_BYTE, MPI_STATUS_IGNORE);
+    MPI_File_close(&fh);
+
+    return header->magic != CHECKPOINT_MAGIC;
 }
 
-// Broadcast the global array of cells to all processes.
-void mpbcast(cart_str cart, int **global_cell_grid, int size) {
-    // Distribute the global cell array from the root process to all other processes in the communicator.
-    MPI_Bcast(&global_cell_grid[0][0], size*size, MPI_INT, 0, cart.comm2d);
+// Read the tile of this process from a checkpoint file into the interior of cell_grid with collective
+// MPI-IO and return the number of live cells in the tile.
+int mpread_checkpoint(char *filename, int **cell_grid, cart_str cart, master_str *master) {
+    int rows = master->dimensions.rows;
+    int cols = master->dimensions.cols;
+    unsigned char *tile = (unsigned char*) malloc((size_t) rows * cols);
+    int live_cells = 0;
+    MPI_File fh;
+
+    if (tile == NULL) {
+        handle_allocation_failure();
+    }
+    MPI_File_open(cart.comm2d, filename, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh);
+    create_checkpoint_view(fh, cart, master);
+    MPI_File_read_all(fh, tile, rows * cols, MPI_BYTE, MPI_STATUS_IGNORE);
+    MPI_File_close(&fh);
+
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < cols; j++) {
+            cell_grid[i + 1][j + 1] = tile[(size_t) i * cols + j];
+            live_cells += cell_grid[i + 1][j + 1];
+        }
+    }
+
+    free(tile);
+    return live_cells;
+}
+
+// Broadcast a single integer from the root process to all processes.
+void mpbcast_int(cart_str cart, int *value) {
+    MPI_Bcast(value, 1, MPI_INT, 0, cart.comm2d);
 }
 
 // Initialize MPI data types for row and column transfers.
@@ -70,20 +513,29 @@ void initialize_mpi_types(MPI_Datatype *column_type, MPI_Datatype *row_type, mas
     MPI_Type_commit(row_type); // Commit the type to use it for MPI operations.
 }
 
-// Initialize a buffer for MPI buffered send operations.
-void initialize_mpi_buffer(void **buffer, int *bsize, master_str *master) {
-    // Calculate the required buffer size.
-    *bsize = (master->dimensions.rows + master->dimensions.cols) * sizeof(int) + MPI_BSEND_OVERHEAD;
-    
-    // Allocate the buffer.
-    *buffer = malloc(*bsize);
-    if (*buffer == NULL) {
-        fprintf(stderr, "Memory allocation failed\n");
-        MPI_Abort(MPI_COMM_WORLD, 1); // Abort MPI execution if memory allocation fails.
-    }
+// Initialize MPI data types for row and column transfers of a byte-per-cell grid.
+void initialize_byte_mpi_types(MPI_Datatype *column_type, MPI_Datatype *row_type, master_str *master) {
+    // Create a vector type for transferring columns.
+    MPI_Type_vector(master->dimensions.rows, 1, master->dimensions.cols + 2, MPI_UINT8_T, column_type);
+    MPI_Type_commit(column_type); // Commit the type to use it for MPI operations.
 
-    // Attach the buffer for use in buffered send operations.
-    MPI_Buffer_attach(*buffer, *bsize);
+    // Create a contiguous type for transferring rows.
+    MPI_Type_contiguous(master->dimensions.cols, MPI_UINT8_T, row_type);
+    MPI_Type_commit(row_type); // Commit the type to use it for MPI operations.
+}
+
+// Initialize MPI data types for the column and row blocks of a grid with halos of the given depth.
+// A row block spans the full padded width, so exchanging rows after columns also fills the corners.
+void initialize_deep_mpi_types(MPI_Datatype *column_type, MPI_Datatype *row_type, int depth, master_str *master) {
+    int stride = master->dimensions.cols + 2 * depth;
+
+    // Create a vector type for transferring depth columns of the interior rows.
+    MPI_Type_vector(master->dimensions.rows, depth, stride, MPI_INT, column_type);
+    MPI_Type_commit(column_type); // Commit the type to use it for MPI operations.
+
+    // Create a contiguous type for transferring depth full-width rows.
+    MPI_Type_contiguous(depth * stride, MPI_INT, row_type);
+    MPI_Type_commit(row_type); // Commit the type to use it for MPI operations.
 }
 
 // Send halo cells to neighboring processes.
@@ -104,19 +556,134 @@ void receive_halo_cells(int **cell_grid, MPI_Datatype row_type, MPI_Datatype col
     MPI_Irecv(&cell_grid[1][master->dimensions.cols+1], 1, column_type, cart.right.val, 4, cart.comm2d, &reqs[7]); // Receive right column.
 }
 
+// Post the sends and receives of the halo cells without waiting for them, so that computation
+// which does not touch the halos or the edge cells can proceed in the meantime.
+void start_halo_exchange(int **cell_grid, MPI_Datatype row_type, MPI_Datatype column_type, cart_str cart, MPI_Request reqs[], master_str *master) {
+    send_halo_cells(cell_grid, row_type, column_type, cart, reqs, master);
+    receive_halo_cells(cell_grid, row_type, column_type, cart, reqs, master);
+}
+
+// Create persistent sends and receives of the halo cells of a grid, in the order of send_halo_cells
+// and receive_halo_cells, to be started with MPI_Startall on every step and freed at the end.
+void init_halo_exchange(int **cell_grid, MPI_Datatype row_type, MPI_Datatype column_type, cart_str cart, MPI_Request reqs[], master_str *master) {
+    int rows = master->dimensions.rows;
+    int cols = master->dimensions.cols;
+
+    MPI_Send_init(&cell_grid[rows][1], 1, row_type, cart.down.val, 1, cart.comm2d, &reqs[0]); // Send bottom row.
+    MPI_Send_init(&cell_grid[1][1], 1, row_type, cart.up.val, 2, cart.comm2d, &reqs[2]); // Send top row.
+    MPI_Send_init(&cell_grid[1][cols], 1, column_type, cart.right.val, 3, cart.comm2d, &reqs[4]); // Send right column.
+    MPI_Send_init(&cell_grid[1][1], 1, column_type, cart.left.val, 4, cart.comm2d, &reqs[6]); // Send left column.
+    MPI_Recv_init(&cell_grid[0][1], 1, row_type, cart.up.val, 1, cart.comm2d, &reqs[1]); // Receive top row.
+    MPI_Recv_init(&cell_grid[rows + 1][1], 1, row_type, cart.down.val, 2, cart.comm2d, &reqs[3]); // Receive bottom row.
+    MPI_Recv_init(&cell_grid[1][0], 1, column_type, cart.left.val, 3, cart.comm2d, &reqs[5]); // Receive left column.
+    MPI_Recv_init(&cell_grid[1][cols + 1], 1, column_type, cart.right.val, 4, cart.comm2d, &reqs[7]); // Receive right column.
+}
+
+// Wait for a halo exchange posted by start_halo_exchange to complete.
+void wait_halo_exchange(MPI_Request reqs[]) {
+    MPI_Status status[8];
+    MPI_Waitall(8, reqs, status);
+}
+
 // Coordinate the exchange of halo cells around the grid.
 void exchange_halo_cells(int **cell_grid, MPI_Datatype row_type, MPI_Datatype column_type, cart_str cart, master_str *master) {
-    MPI_Status status[8];
     MPI_Request reqs[8];
 
     // Initiate asynchronous sends and receives.
-    send_halo_cells(cell_grid, row_type, column_type, cart, reqs, master);
+    start_halo_exchange(cell_grid, row_type, column_type, cart, reqs, master);
+
+    // Wait for all communication operations to complete.
+    wait_halo_exchange(reqs);
+}
+
+// Coordinate the exchange of halo cells, sending an empty message in place of each edge that is the
+// same as two steps back, flagged in send in the order of send_halo_cells. An empty receive leaves the
+// halo the grid received two steps back, which is then still current. The halos that were received
+// are flagged in received as top, bottom, left and right.
+void exchange_active_halo_cells(int **cell_grid, MPI_Datatype row_type, MPI_Datatype column_type, int send[4], int received[4], cart_str cart, master_str *master) {
+    MPI_Status status[8];
+    MPI_Request reqs[8];
+    int rows = master->dimensions.rows;
+    int cols = master->dimensions.cols;
+
+    MPI_Isend(&cell_grid[rows][1], send[0], row_type, cart.down.val, 1, cart.comm2d, &reqs[0]); // Send bottom row.
+    MPI_Isend(&cell_grid[1][1], send[1], row_type, cart.up.val, 2, cart.comm2d, &reqs[2]); // Send top row.
+    MPI_Isend(&cell_grid[1][cols], send[2], column_type, cart.right.val, 3, cart.comm2d, &reqs[4]); // Send right column.
+    MPI_Isend(&cell_grid[1][1], send[3], column_type, cart.left.val, 4, cart.comm2d, &reqs[6]); // Send left column.
     receive_halo_cells(cell_grid, row_type, column_type, cart, reqs, master);
+    MPI_Waitall(8, reqs, status);
+
+    // A receive from MPI_PROC_NULL is empty too, and the zero halo it stands for never changes.
+    MPI_Get_count(&status[1], row_type, &received[0]);
+    MPI_Get_count(&status[3], row_type, &received[1]);
+    MPI_Get_count(&status[5], column_type, &received[2]);
+    MPI_Get_count(&status[7], column_type, &received[3]);
+}
+
+// Coordinate the exchange of halo cells of a bit-packed grid. Rows are sent as whole packed
+// words, columns as bit-packed buffers filled by pack_halo_columns.
+void exchange_packed_halo_cells(uint64_t **packed_grid, uint64_t *send_left, uint64_t *send_right, uint64_t *recv_left, uint64_t *recv_right,
+                                int nwords, int ncolumnwords, cart_str cart, master_str *master) {
+    MPI_Status status[8];
+    MPI_Request reqs[8];
+    int rows = master->dimensions.rows;
+
+    MPI_Isend(packed_grid[rows], nwords, MPI_UINT64_T, cart.down.val, 1, cart.comm2d, &reqs[0]); // Send bottom row.
+    MPI_Isend(packed_grid[1], nwords, MPI_UINT64_T, cart.up.val, 2, cart.comm2d, &reqs[2]); // Send top row.
+    MPI_Isend(send_right, ncolumnwords, MPI_UINT64_T, cart.right.val, 3, cart.comm2d, &reqs[4]); // Send right column.
+    MPI_Isend(send_left, ncolumnwords, MPI_UINT64_T, cart.left.val, 4, cart.comm2d, &reqs[6]); // Send left column.
+
+    MPI_Irecv(packed_grid[0], nwords, MPI_UINT64_T, cart.up.val, 1, cart.comm2d, &reqs[1]); // Receive top row.
+    MPI_Irecv(packed_grid[rows + 1], nwords, MPI_UINT64_T, cart.down.val, 2, cart.comm2d, &reqs[3]); // Receive bottom row.
+    MPI_Irecv(recv_left, ncolumnwords, MPI_UINT64_T, cart.left.val, 3, cart.comm2d, &reqs[5]); // Receive left column.
+    MPI_Irecv(recv_right, ncolumnwords, MPI_UINT64_T, cart.right.val, 4, cart.comm2d, &reqs[7]); // Receive right column.
+
+    // Wait for all communication operations to complete.
+    MPI_Waitall(8, reqs, status);
+}
+
+// Coordinate the exchange of halo cells of a byte-per-cell grid around the grid.
+void exchange_byte_halo_cells(uint8_t **byte_grid, MPI_Datatype row_type, MPI_Datatype column_type, cart_str cart, master_str *master) {
+    MPI_Status status[8];
+    MPI_Request reqs[8];
+    int rows = master->dimensions.rows;
+    int cols = master->dimensions.cols;
+
+    MPI_Isend(&byte_grid[rows][1], 1, row_type, cart.down.val, 1, cart.comm2d, &reqs[0]); // Send bottom row.
+    MPI_Isend(&byte_grid[1][1], 1, row_type, cart.up.val, 2, cart.comm2d, &reqs[2]); // Send top row.
+    MPI_Isend(&byte_grid[1][cols], 1, column_type, cart.right.val, 3, cart.comm2d, &reqs[4]); // Send right column.
+    MPI_Isend(&byte_grid[1][1], 1, column_type, cart.left.val, 4, cart.comm2d, &reqs[6]); // Send left column.
+
+    MPI_Irecv(&byte_grid[0][1], 1, row_type, cart.up.val, 1, cart.comm2d, &reqs[1]); // Receive top row.
+    MPI_Irecv(&byte_grid[rows + 1][1], 1, row_type, cart.down.val, 2, cart.comm2d, &reqs[3]); // Receive bottom row.
+    MPI_Irecv(&byte_grid[1][0], 1, column_type, cart.left.val, 3, cart.comm2d, &reqs[5]); // Receive left column.
+    MPI_Irecv(&byte_grid[1][cols + 1], 1, column_type, cart.right.val, 4, cart.comm2d, &reqs[7]); // Receive right column.
 
     // Wait for all communication operations to complete.
     MPI_Waitall(8, reqs, status);
 }
 
+// Fill the halos of depth depth, corners included. Columns are exchanged first; the row blocks then
+// carry the freshly received halo columns to the diagonal neighbours.
+void exchange_deep_halo_cells(int **cell_grid, MPI_Datatype row_type, MPI_Datatype column_type, int depth, cart_str cart, master_str *master) {
+    MPI_Status status[4];
+    MPI_Request reqs[4];
+    int rows = master->dimensions.rows;
+    int cols = master->dimensions.cols;
+
+    MPI_Isend(&cell_grid[1][cols - depth + 1], 1, column_type, cart.right.val, 3, cart.comm2d, &reqs[0]); // Send right columns.
+    MPI_Isend(&cell_grid[1][1], 1, column_type, cart.left.val, 4, cart.comm2d, &reqs[1]); // Send left columns.
+    MPI_Irecv(&cell_grid[1][1 - depth], 1, column_type, cart.left.val, 3, cart.comm2d, &reqs[2]); // Receive left columns.
+    MPI_Irecv(&cell_grid[1][cols + 1], 1, column_type, cart.right.val, 4, cart.comm2d, &reqs[3]); // Receive right columns.
+    MPI_Waitall(4, reqs, status);
+
+    MPI_Isend(&cell_grid[rows - depth + 1][1 - depth], 1, row_type, cart.down.val, 1, cart.comm2d, &reqs[0]); // Send bottom rows.
+    MPI_Isend(&cell_grid[1][1 - depth], 1, row_type, cart.up.val, 2, cart.comm2d, &reqs[1]); // Send top rows.
+    MPI_Irecv(&cell_grid[1 - depth][1 - depth], 1, row_type, cart.up.val, 1, cart.comm2d, &reqs[2]); // Receive top rows.
+    MPI_Irecv(&cell_grid[rows + 1][1 - depth], 1, row_type, cart.down.val, 2, cart.comm2d, &reqs[3]); // Receive bottom rows.
+    MPI_Waitall(4, reqs, status);
+}
+
 double mpgsum(cart_str cart, double *local_sum)
 {
   double global_sum;
@@ -126,6 +693,36 @@ double mpgsum(cart_str cart, double *local_sum)
   return global_sum;
 } 
 
+double mpgmax(cart_str cart, double *local_value)
+{
+  double global_max;
+
+  MPI_Allreduce(local_value, &global_max, 1, MPI_DOUBLE, MPI_MAX, cart.comm2d);
+
+  return global_max;
+}
+
+double mpgmaxloc(cart_str cart, double *local_value, int *rank)
+{
+  struct { double value; int rank; } local, global;
+
+  local.value = *local_value;
+  MPI_Comm_rank(cart.comm2d, &local.rank);
+  MPI_Allreduce(&local, &global, 1, MPI_DOUBLE_INT, MPI_MAXLOC, cart.comm2d);
+  *rank = global.rank;
+
+  return global.value;
+}
+
+double mpgmin(cart_str cart, double *local_value)
+{
+  double global_min;
+
+  MPI_Allreduce(local_value, &global_min, 1, MPI_DOUBLE, MPI_MIN, cart.comm2d);
+
+  return global_min;
+}
+
 double gettime(void)
 { 
   return MPI_Wtime(); 
@@ -2,6 +2,7 @@
 #define MPILIB_H
 
 #include <mpi.h>
+#include <stdint.h>
 #include "structs.h"  // Include necessary structures like cart_str, comm_str, etc.
 
 // Starts the MPI environment
@@ -13,20 +14,35 @@ void mpstop(void);
 // Sets up a Cartesian topology based on the communication structure
 void setup_cartesian_topology(comm_str *comm, cart_str *cart);
 
-// Reduces local cell counts to a global count across all processes
-void mpi_reduce_localncell(cart_str cart, int local_live_cells, int *total_live_cells);
+// Replaces the Cartesian topology with the process grid that sends the fewest halo cells between nodes, placing each node on a block of it
+void setup_node_aware_topology(comm_str *comm, cart_str *cart);
 
-// Broadcasts data to all processes in the MPI topology
-void mpbcast(cart_str cart, int **global_cell_grid, int size);
+// Prints the process grid and the halo bytes sent per step in total, between nodes and by the busiest process
+void report_topology(master_str *master);
+
+// Reduces local cell counts to a global count available on all processes
+int mpi_allreduce_localncell(cart_str cart, int local_live_cells);
+
+// Broadcasts a single integer from the root process to all processes
+void mpbcast_int(cart_str cart, int *value);
 
 // Initializes MPI data types for row and column communications
 void initialize_mpi_types(MPI_Datatype *column_type, MPI_Datatype *row_type, master_str *master);
 
-// Allocates and attaches an MPI buffer for optimized communication
-void initialize_mpi_buffer(void **buffer, int *bsize, master_str *master);
+// Initializes MPI data types for row and column communications of a byte-per-cell grid
+void initialize_byte_mpi_types(MPI_Datatype *column_type, MPI_Datatype *row_type, master_str *master);
+
+// Initializes MPI data types for the column and row blocks of a deep halo grid
+void initialize_deep_mpi_types(MPI_Datatype *column_type, MPI_Datatype *row_type, int depth, master_str *master);
 
-// Reduces data from all cells across processes, used in gathering operations
-void mpi_reduce_allcell(cart_str cart, int **reduction_cell_grid, int **global_cell_grid, int size);
+// Splits a landscape into blocks differing in size by at most one and returns the range of one block
+void block_decomposition(int landscape, int nblocks, int block, int *first, int *size);
+
+// Sends every process its tile of the global landscape held by the root
+void mpscatter_tiles(cart_str cart, int **global_cell_grid, int **local_cell_grid, master_str *master);
+
+// Collects the tile of every process into the global landscape on the root
+void mpgather_tiles(cart_str cart, int **local_cell_grid, int **global_cell_grid, master_str *master);
 
 // Sends boundary cell data to adjacent processes
 void send_halo_cells(int **cell_grid, MPI_Datatype row_type, MPI_Datatype column_type, cart_str cart, MPI_Request reqs[], master_str *master);
@@ -34,12 +50,67 @@ void send_halo_cells(int **cell_grid, MPI_Datatype row_type, MPI_Datatype column
 // Receives boundary cell data from adjacent processes
 void receive_halo_cells(int **cell_grid, MPI_Datatype row_type, MPI_Datatype column_type, cart_str cart, MPI_Request reqs[], master_str *master);
 
+// Posts the non-blocking exchange of boundary cells between adjacent processes
+void start_halo_exchange(int **cell_grid, MPI_Datatype row_type, MPI_Datatype column_type, cart_str cart, MPI_Request reqs[], master_str *master);
+
+// Creates persistent sends and receives of the halo cells of a grid, in the order of start_halo_exchange
+void init_halo_exchange(int **cell_grid, MPI_Datatype row_type, MPI_Datatype column_type, cart_str cart, MPI_Request reqs[], master_str *master);
+
+// Waits for a boundary cell exchange posted by start_halo_exchange to complete
+void wait_halo_exchange(MPI_Request reqs[]);
+
 // Coordinates the exchange of boundary cells between adjacent processes
 void exchange_halo_cells(int **cell_grid, MPI_Datatype row_type, MPI_Datatype column_type, cart_str cart, master_str *master);
 
+// Exchanges boundary cells, sending empty messages for the edges that are the same as two steps back
+void exchange_active_halo_cells(int **cell_grid, MPI_Datatype row_type, MPI_Datatype column_type, int send[4], int received[4], cart_str cart, master_str *master);
+
+// Coordinates the exchange of boundary cells of a bit-packed grid between adjacent processes
+void exchange_packed_halo_cells(uint64_t **packed_grid, uint64_t *send_left, uint64_t *send_right, uint64_t *recv_left, uint64_t *recv_right,
+                                int nwords, int ncolumnwords, cart_str cart, master_str *master);
+
+// Coordinates the exchange of boundary cells of a byte-per-cell grid between adjacent processes
+void exchange_byte_halo_cells(uint8_t **byte_grid, MPI_Datatype row_type, MPI_Datatype column_type, cart_str cart, master_str *master);
+
+// Coordinates the exchange of deep halos, corners included, between adjacent processes
+void exchange_deep_halo_cells(int **cell_grid, MPI_Datatype row_type, MPI_Datatype column_type, int depth, cart_str cart, master_str *master);
+
 // Computes the global sum of a variable across all processes in the MPI topology
 double mpgsum(cart_str cart, double *local_sum);
 
+// Returns whether every process can write its own part of the binary image
+int mpwrite_supported(master_str *master);
+
+// Packs the tiles and starts writing them collectively as one binary PBM image with non-blocking MPI-IO
+void mpwrite_cells_start(char *cellfile, int **cell_grid, int halo, image_str *image, cart_str cart, master_str *master);
+
+// Completes a pending image write and closes its file
+void mpwrite_cells_wait(image_str *image);
+
+// Completes a pending image write and releases the image buffer
+void mpwrite_cells_free(image_str *image);
+
+// Writes the local tiles collectively as one binary PBM image with MPI-IO
+void mpwrite_cells(char *cellfile, int **local_cell_grid, cart_str cart, master_str *master);
+
+// Writes the cells and the header to a checkpoint file collectively with MPI-IO
+int mpwrite_checkpoint(char *filename, int **cell_grid, checkpoint_str *header, cart_str cart, master_str *master);
+
+// Reads the header of a checkpoint file on every process
+int mpread_checkpoint_header(char *filename, checkpoint_str *header, cart_str cart);
+
+// Reads the tile of this process from a checkpoint file collectively with MPI-IO
+int mpread_checkpoint(char *filename, int **cell_grid, cart_str cart, master_str *master);
+
+// Computes the global maximum of a variable across all processes in the MPI topology
+double mpgmax(cart_str cart, double *local_value);
+
+// Computes the global maximum of a variable and the rank that holds it
+double mpgmaxloc(cart_str cart, double *local_value, int *rank);
+
+// Computes the global minimum of a variable across all processes in the MPI topology
+double mpgmin(cart_str cart, double *local_value);
+
 // Returns the current time, useful for performance measurement
 double gettime(void);
 
@@ -8,6 +8,11 @@
 #include "mem.h"
 #include "misc.h"
 #include "mplib.h"
+#include "halolib.h"
+#include "bitlib.h"
+#ifdef SIMD
+#include "simdlib.h"
+#endif
 
 #define FIRSTPERIODICBOUNDARYDIVISOR 8
 #define SECONDPERIODICBOUNDARYDIVISOR 7
@@ -22,84 +27,645 @@ void par_initialise_comm(master_str *master) {
 // Initializes and distributes data structures across processes for parallel computation
 void par_initialise_and_distribute(master_str *master, int **cell_grid, int **global_cell_grid, int **local_cell_grid, int live_cells) {
     if (master->comm.rank == 0) {
-        printf("automaton: running on %d process(es)\n", master->comm.size);
+        printf("automaton: running on %d process(es), %d thread(s) each\n", master->comm.size, master->params.threads);
         printf("automaton: L = %d, rho = %f, seed = %d, maxstep = %d\n",
                master->params.landscape, master->params.rho, master->params.seed, master->params.maxstep);
+    }
+    report_rule(master);
+    report_topology(master);
+
+    // Every rank reads its own tile of the checkpoint, whatever the number of processes that wrote it.
+    if (master->params.restart != NULL) {
+        live_cells = mpread_checkpoint(master->params.restart, cell_grid, master->cart, master);
+        live_cells = mpi_allreduce_localncell(master->cart, live_cells);
+        if (master->comm.rank == 0) {
+            printf("automaton: live cells = %d after step %d\n", live_cells, master->start_step);
+        }
+        zero_top_bottom_halos(cell_grid, master);
+        zero_left_right_halos(cell_grid, master);
+        return;
+    }
+
+    // Every rank generates its own tile, so nothing is broadcast.
+    if (master->params.init == counter_init) {
+        initialize_tile_cells(cell_grid, master, &live_cells);
+        report_initial_cells(master, mpi_allreduce_localncell(master->cart, live_cells));
+        zero_top_bottom_halos(cell_grid, master);
+        zero_left_right_halos(cell_grid, master);
+        return;
+    }
+
+    if (master->comm.rank == 0) {
         rinit(master->params.seed);
         initialize_cells(master->params.landscape, global_cell_grid, master, &live_cells);
     }
-    mpbcast(master->cart, global_cell_grid, master->params.landscape);
-    distribute_cells(local_cell_grid, global_cell_grid, master);
+    mpscatter_tiles(master->cart, global_cell_grid, local_cell_grid, master);
+    mpbcast_int(master->cart, &master->initialcells);  // Every rank checks the termination threshold
     copy_data_to_cell_grid(cell_grid, local_cell_grid, master);
     zero_top_bottom_halos(cell_grid, master);
     zero_left_right_halos(cell_grid, master);
 }
 
-// Processes the cell data in parallel, managing data exchange and computation across processes
-void par_process(master_str *master, int **cell_grid, int **neighbor_grid) {
+// Reduces the live cells on the print steps only, the sole steps on which the total is used. Every
+// rank receives the total and takes the same termination decision. Returns true to stop the run.
+static bool report_live_cells(master_str *master, int local_live_cells, int step) {
+    // A single process needs no reduction, so it checks the threshold every step as ser_process does.
+    if (master->params.version == serial) {
+        if (step % master->params.printfreq == 0) {
+            printf("automaton: number of live cells on step %d is %d\n", step, local_live_cells);
+        }
+        return should_terminate(local_live_cells, master, step);
+    }
+    if (step % master->params.printfreq != 0) {
+        return false;
+    }
+    double reduce_start = gettime();
+    int total_live_cells = mpi_allreduce_localncell(master->cart, local_live_cells);
+    master->time.reduce += gettime() - reduce_start;
+    if (master->comm.rank == 0) {
+        printf("automaton: number of live cells on step %d is %d\n", step, total_live_cells);
+    }
+    return should_terminate(total_live_cells, master, step);
+}
+
+// With -profile, add the time since the end of the last phase timed to phase p. The first phase of a
+// step starts at the mark set by profile_mark, which also keeps untimed work out of the phases.
+static void profile_phase(master_str *master, phase p) {
+    if (master->params.profile) {
+        double now = gettime();
+        master->profile.time[p] += now - master->profile.mark;
+        master->profile.mark = now;
+    }
+}
+
+// With -profile, start the next phase timed now.
+static void profile_mark(master_str *master) {
+    if (master->params.profile) {
+        master->profile.mark = gettime();
+    }
+}
+
+// Print the minimum, mean and maximum over the ranks of the time of each phase of the steps, the
+// rank with the maximum and the imbalance, maximum over mean. A phase whose maximum is well above its
+// mean points to the ranks that hold up the others, which the others spend waiting for halos.
+static void par_print_profile(master_str *master, int steps) {
+    static const char *names[nphases] = {"halo post", "halo wait", "boundary adjust", "neighbour count", "update", "live-cell reduction"};
+    double total = 0.0;
+
+    if (master->comm.rank == 0) {
+        printf("automaton: profile of %d steps on %d processes, seconds per process\n", steps, master->comm.size);
+        printf("  %-20s %12s %12s %12s %6s %10s\n", "phase", "min", "mean", "max", "rank", "max/mean");
+    }
+    for (int p = 0; p < nphases; p++) {
+        int rank;
+        double min = mpgmin(master->cart, &master->profile.time[p]);
+        double mean = mpgsum(master->cart, &master->profile.time[p]) / master->comm.size;
+        double max = mpgmaxloc(master->cart, &master->profile.time[p], &rank);
+        total += master->profile.time[p];
+        if (master->comm.rank == 0) {
+            printf("  %-20s %12f %12f %12f %6d %10.2f\n", names[p], min, mean, max, rank, mean > 0.0 ? max / mean : 1.0);
+        }
+    }
+    int rank;
+    double min = mpgmin(master->cart, &total);
+    double mean = mpgsum(master->cart, &total) / master->comm.size;
+    double max = mpgmaxloc(master->cart, &total, &rank);
+    if (master->comm.rank == 0) {
+        printf("  %-20s %12f %12f %12f %6d %10.2f\n", "total", min, mean, max, rank, mean > 0.0 ? max / mean : 1.0);
+    }
+}
+
+// Computes the cells of a region with the selected engine. The fused engine writes the next generation
+// into next_grid and returns its live cells; the int engine only counts the neighbours into it.
+static int compute_region(master_str *master, int **cell_grid, int **next_grid, int row_start, int row_end, int col_start, int col_end) {
+    if (master->params.engine == fused_engine) {
+        return update_cells_fused_region(cell_grid, next_grid, row_start, row_end, col_start, col_end, &master->params.rule);
+    }
+    calculate_neighbors_region(cell_grid, next_grid, row_start, row_end, col_start, col_end);
+    return 0;
+}
+
+// Computes the strip of cells that read halo data: the first and last rows and columns.
+static int compute_edges(master_str *master, int **cell_grid, int **next_grid) {
+    int rows = master->dimensions.rows;
+    int cols = master->dimensions.cols;
+    int live_cells = compute_region(master, cell_grid, next_grid, 1, 1, 1, cols);
+    if (rows > 1) {
+        live_cells += compute_region(master, cell_grid, next_grid, rows, rows, 1, cols);
+    }
+    if (rows > 2) {
+        live_cells += compute_region(master, cell_grid, next_grid, 2, rows - 1, 1, 1);
+        if (cols > 1) {
+            live_cells += compute_region(master, cell_grid, next_grid, 2, rows - 1, cols, cols);
+        }
+    }
+    return live_cells;
+}
+
+// Processes the cell data in parallel, managing data exchange and computation across processes.
+// The fused engine swaps cell_grid and neighbor_grid every step, so both pointers may be exchanged on return.
+void par_process(master_str *master, int ***cell_grid, int ***neighbor_grid) {
     MPI_Datatype column_type, row_type;
-    void *buffer;
-    int bsize;
 
     initialize_mpi_types(&column_type, &row_type, master);
-    initialize_mpi_buffer(&buffer, &bsize, master);
 
-    int local_live_cells, total_live_cells;
+    if (master->params.engine == fused_engine) {
+        zero_top_bottom_halos(*neighbor_grid, master);
+        zero_left_right_halos(*neighbor_grid, master);
+    }
+    halo_str halo;
+    create_halo(&halo, cell_grid, neighbor_grid, row_type, column_type, master);
+
+    int rows = master->dimensions.rows;
+    int cols = master->dimensions.cols;
+    int local_live_cells;
+    active_str active;
+    int edges[4];
+    int halos[4];
+    int neighbours[4] = {master->cart.down.val, master->cart.up.val, master->cart.right.val, master->cart.left.val};
+    // The fused engine counts the neighbours while it updates the cells.
+    phase compute = (master->params.engine == fused_engine) ? update_phase : count_phase;
+    int steps = 0;
+    if (master->params.active) {
+        create_active_blocks(&active, master);
+    }
     par_start_timing(master);
 
-    for (int step = 1; step <= master->params.maxstep; step++) {
-        exchange_halo_cells(cell_grid, row_type, column_type, master->cart, master);
+    for (int step = master->start_step + 1; step <= master->params.maxstep; step++) {
         int periodic_boundary_start = master->params.landscape / FIRSTPERIODICBOUNDARYDIVISOR + OFFSET;
         int periodic_boundary_end = (SECONDPERIODICBOUNDARYDIVISOR * master->params.landscape) / FIRSTPERIODICBOUNDARYDIVISOR;
-        adjust_boundaries(cell_grid, master->cart, periodic_boundary_start, periodic_boundary_end, master);
-        calculate_neighbors(cell_grid, neighbor_grid, master);
-        update_cells(cell_grid, neighbor_grid, &local_live_cells, master);
-        mpi_reduce_localncell(master->cart, local_live_cells, &total_live_cells);
-
-        if (master->comm.rank == 0 && (step % master->params.printfreq == 0)) {
-            printf("automaton: number of live cells on step %d is %d\n", step, total_live_cells);
-            if (should_terminate(total_live_cells, master, step)) {
-                break;  // Terminate if function returns true
+        double step_start = gettime();
+        profile_mark(master);
+
+        if (master->params.overlap) {
+            // The interior reads no halo cells, so it is computed while the halos are in flight.
+            post_halo(&halo, *cell_grid, master);
+            profile_phase(master, post_phase);
+            local_live_cells = compute_region(master, *cell_grid, *neighbor_grid, 2, rows - 1, 2, cols - 1);
+            profile_phase(master, compute);
+            double wait_start = gettime();
+            complete_halo(&halo, *cell_grid, master);
+            master->time.halo += gettime() - wait_start;
+            profile_phase(master, wait_phase);
+            adjust_boundaries(*cell_grid, master->cart, periodic_boundary_start, periodic_boundary_end, master);
+            profile_phase(master, adjust_phase);
+            local_live_cells += compute_edges(master, *cell_grid, *neighbor_grid);
+            profile_phase(master, compute);
+        } else if (master->params.active) {
+            // Edges that are the same as two steps back are sent as empty messages.
+            active_edges(&active, edges);
+            for (int d = 0; d < 4; d++) {
+                if (neighbours[d] != MPI_PROC_NULL) {
+                    active.messages++;
+                    active.skipped += !edges[d];
+                }
             }
+            profile_phase(master, post_phase);
+            // The exchange posts and waits in one call, so its time counts as waiting.
+            exchange_active_halo_cells(*cell_grid, row_type, column_type, edges, halos, master->cart, master);
+            master->time.halo += gettime() - step_start;
+            profile_phase(master, wait_phase);
+            adjust_boundaries(*cell_grid, master->cart, periodic_boundary_start, periodic_boundary_end, master);
+            profile_phase(master, adjust_phase);
+            local_live_cells = update_cells_active(*cell_grid, *neighbor_grid, halos, &active, master);
+            profile_phase(master, update_phase);
+        } else {
+            post_halo(&halo, *cell_grid, master);
+            profile_phase(master, post_phase);
+            complete_halo(&halo, *cell_grid, master);
+            master->time.halo += gettime() - step_start;
+            profile_phase(master, wait_phase);
+            adjust_boundaries(*cell_grid, master->cart, periodic_boundary_start, periodic_boundary_end, master);
+            profile_phase(master, adjust_phase);
+            local_live_cells = compute_region(master, *cell_grid, *neighbor_grid, 1, rows, 1, cols);
+            profile_phase(master, compute);
+        }
+
+        if (master->params.engine == fused_engine) {
+            swap_arrays(cell_grid, neighbor_grid);
+        } else {
+            update_cells(*cell_grid, *neighbor_grid, &local_live_cells, master);
+            profile_phase(master, update_phase);
+        }
+        master->time.step += gettime() - step_start;
+
+        take_snapshot(*cell_grid, step, master);
+        take_checkpoint(*cell_grid, step, master);
+
+        profile_mark(master);
+        bool terminate = report_live_cells(master, local_live_cells, step);
+        profile_phase(master, reduce_phase);
+        steps++;
+        if (master->params.active && (step % master->params.printfreq == 0 || terminate)) {
+            report_active_blocks(&active, step, master);
+        }
+        if (terminate) {
+            break;  // Terminate if function returns true
         }
     }
 
+    if (master->params.active) {
+        free_active_blocks(&active);
+    }
+    free_halo(&halo, cell_grid, neighbor_grid, master);
+    finish_snapshots(master);
     par_stop_timing(master);  // Stop timing and calculate
 
     if (master->comm.rank == 0) {
         par_print_timing(master);  // Print the results
     }
+    if (master->params.profile) {
+        par_print_profile(master, steps);
+    }
 
     MPI_Type_free(&column_type);
     MPI_Type_free(&row_type);
-    MPI_Buffer_detach(&buffer, &bsize);
-    free(buffer);
 }
 
+// Advances row i of a deep halo grid by one step over the columns whose halos are still valid, depth
+// cells beyond the tile (never beyond the non-periodic left and right edges of the landscape). The
+// top and bottom edge rows of the landscape see each other only inside the periodic band, so across
+// that seam the neighbouring row is read through the boundary mask. Returns the live tile cells.
+static int deep_halo_row(int **cell_grid, int **next_grid, int i, int depth, int *boundary_mask, int *seam_row, master_str *master) {
+    int rows = master->dimensions.rows;
+    int cols = master->dimensions.cols;
+    int top = (master->cart.coords[0] == 0);
+    int bottom = (master->cart.coords[0] == master->cart.dims[0] - 1);
+    int col_start = (master->cart.left.val == MPI_PROC_NULL) ? 1 : 1 - depth;
+    int col_end = (master->cart.right.val == MPI_PROC_NULL) ? cols : cols + depth;
+    const int *up = cell_grid[i - 1];
+    const int *down = cell_grid[i + 1];
+    const rule_str *rule = &master->params.rule;
+    int seam = -1;
+
+    if (top && (i == 1 || i == 0)) {
+        seam = (i == 1) ? 0 : 1;
+    } else if (bottom && (i == rows || i == rows + 1)) {
+        seam = (i == rows) ? rows + 1 : rows;
+    }
+    if (seam >= 0) {
+        // The Moore neighbourhood also reads the seam row one column beyond each end
+        for (int j = col_start - 1; j <= col_end + 1; j++) {
+            seam_row[j] = cell_grid[seam][j] & boundary_mask[j];
+        }
+        if (seam < i) {
+            up = seam_row;
+        } else {
+            down = seam_row;
+        }
+    }
+
+    if (i < 1 || i > rows) {
+        update_row_fused(up, cell_grid[i], down, next_grid[i], col_start, col_end, rule);
+        return 0;
+    }
+    update_row_fused(up, cell_grid[i], down, next_grid[i], col_start, 0, rule);
+    int live_cells = update_row_fused(up, cell_grid[i], down, next_grid[i], 1, cols, rule);
+    update_row_fused(up, cell_grid[i], down, next_grid[i], cols + 1, col_end, rule);
+    return live_cells;
+}
+
+// Advances a deep halo grid by one step over the region whose halos are still valid, depth cells
+// beyond the tile. Returns the live tile cells.
+static int deep_halo_step(int **cell_grid, int **next_grid, int depth, int *boundary_mask, int *seam_row, master_str *master) {
+    int live_cells = 0;
+    for (int i = 1 - depth; i <= master->dimensions.rows + depth; i++) {
+        live_cells += deep_halo_row(cell_grid, next_grid, i, depth, boundary_mask, seam_row, master);
+    }
+    return live_cells;
+}
+
+// Advances a deep halo grid by levels steps in a single wavefront sweep down the rows, the first
+// step with halos valid depth cells beyond the tile. Step v computes row r - v as soon as step v - 1
+// has computed row r - v + 1, so each row is advanced all levels steps while its neighbourhood is
+// still in cache instead of streaming the whole grid once per step. The steps alternate between the
+// two grids: step v overwrites the rows of step v - 2 that no later row still reads. The result
+// ends in grid[levels % 2], and the live tile cells of each step are returned in live_cells.
+static void deep_halo_wavefront(int **grid[2], int levels, int depth, int *live_cells, int *boundary_mask, int *seam_row, master_str *master) {
+    int rows = master->dimensions.rows;
+
+    for (int v = 0; v < levels; v++) {
+        live_cells[v] = 0;
+    }
+    for (int r = 1 - depth; r <= rows + depth + levels - 1; r++) {
+        for (int v = 0; v < levels; v++) {
+            int valid = depth - v;  // Step v is valid on a region one cell narrower than step v - 1
+            int i = r - v;
+            if (i >= 1 - valid && i <= rows + valid) {
+                live_cells[v] += deep_halo_row(grid[v % 2], grid[(v + 1) % 2], i, valid, boundary_mask, seam_row, master);
+            }
+        }
+    }
+}
+
+// Copies a deep halo grid, halos included.
+static void copy_deep_cells(int **src, int **dst, int depth, master_str *master) {
+    for (int i = 1 - depth; i <= master->dimensions.rows + depth; i++) {
+        memcpy(&dst[i][1 - depth], &src[i][1 - depth], (master->dimensions.cols + 2 * depth) * sizeof(int));
+    }
+}
+
+// Processes the cell data with halos of depth k = -halo: the halos, corners included, are exchanged
+// once and the tile is then advanced k steps on a region shrinking by one cell per step. The fused
+// engine sweeps the region once per step; the temporal engine advances it in wavefront blocks that
+// end on the print steps, where the live cells are reduced and the run may terminate.
+void par_deep_halo_process(master_str *master, int **cell_grid) {
+    MPI_Datatype column_type, row_type;
+    int depth = master->params.halo;
+    int periodic_boundary_start = master->params.landscape / FIRSTPERIODICBOUNDARYDIVISOR + OFFSET;
+    int periodic_boundary_end = (SECONDPERIODICBOUNDARYDIVISOR * master->params.landscape) / FIRSTPERIODICBOUNDARYDIVISOR;
+
+    int **deep_grid = create_deep_cell_array(master, depth);
+    int **next_grid = create_deep_cell_array(master, depth);
+    int *boundary_mask = create_deep_row(master, depth);
+    int *seam_row = create_deep_row(master, depth);
+    // A single process may terminate inside a temporal block, which is then redone from its start
+    int **block_grid = (master->params.engine == temporal_engine && master->params.version == serial) ? create_deep_cell_array(master, depth) : NULL;
+
+    for (int j = 1 - depth; j <= master->dimensions.cols + depth; j++) {
+        int index = master->dimensions.first_col + j;
+        boundary_mask[j] = (index >= periodic_boundary_start && index <= periodic_boundary_end);
+    }
+
+    initialize_deep_mpi_types(&column_type, &row_type, depth, master);
+    copy_interior_cells(cell_grid, deep_grid, master);
+
+    int local_live_cells;
+    int terminate = 0;
+    par_start_timing(master);
+
+    for (int step = master->start_step + 1; step <= master->params.maxstep && !terminate; ) {
+        double exchange_start = gettime();
+        exchange_deep_halo_cells(deep_grid, row_type, column_type, depth, master->cart, master);
+        master->time.halo += gettime() - exchange_start;
+        master->time.step += gettime() - exchange_start;
+
+        if (master->params.engine == temporal_engine) {
+            for (int valid = depth - 1; valid >= 0 && step <= master->params.maxstep && !terminate; ) {
+                int levels = valid + 1;
+                int live_cells[depth];
+                int **grid[2] = {deep_grid, next_grid};
+                double block_start = gettime();
+
+                // Blocks stop on the print steps, the only steps whose state is reported
+                if (levels > master->params.maxstep - step + 1) {
+                    levels = master->params.maxstep - step + 1;
+                }
+                if (levels > master->params.printfreq - (step - 1) % master->params.printfreq) {
+                    levels = master->params.printfreq - (step - 1) % master->params.printfreq;
+                }
+                if (block_grid != NULL) {
+                    copy_deep_cells(deep_grid, block_grid, depth, master);
+                }
+                deep_halo_wavefront(grid, levels, valid, live_cells, boundary_mask, seam_row, master);
+                if (levels % 2) {
+                    swap_arrays(&deep_grid, &next_grid);
+                }
+                master->time.step += gettime() - block_start;
+
+                for (int v = 0; v < levels && !terminate; v++, step++) {
+                    terminate = report_live_cells(master, live_cells[v], step);
+                    if (terminate && v < levels - 1) {
+                        int **redo[2] = {block_grid, next_grid};
+                        deep_halo_wavefront(redo, v + 1, valid, live_cells, boundary_mask, seam_row, master);
+                        if ((v + 1) % 2) {
+                            swap_arrays(&deep_grid, &next_grid);
+                        } else {
+                            swap_arrays(&deep_grid, &block_grid);
+                        }
+                    }
+                }
+                valid -= levels;
+            }
+            continue;
+        }
+
+        for (int valid = depth - 1; valid >= 0 && step <= master->params.maxstep; valid--, step++) {
+            double step_start = gettime();
+            local_live_cells = deep_halo_step(deep_grid, next_grid, valid, boundary_mask, seam_row, master);
+            swap_arrays(&deep_grid, &next_grid);
+            master->time.step += gettime() - step_start;
+            if (report_live_cells(master, local_live_cells, step)) {
+                terminate = 1;  // Terminate if function returns true
+                break;
+            }
+        }
+    }
+
+    par_stop_timing(master);  // Stop timing and calculate
+
+    if (master->comm.rank == 0) {
+        par_print_timing(master);  // Print the results
+    }
+
+    copy_interior_cells(deep_grid, cell_grid, master);
+
+    MPI_Type_free(&column_type);
+    MPI_Type_free(&row_type);
+    free_deep_cell_array(deep_grid, depth);
+    free_deep_cell_array(next_grid, depth);
+    if (block_grid != NULL) {
+        free_deep_cell_array(block_grid, depth);
+    }
+    free_deep_row(boundary_mask, depth);
+    free_deep_row(seam_row, depth);
+}
+
+// Processes the cell data in parallel with the bit-packed engine, exchanging packed rows and columns
+void par_bit_process(master_str *master, int **cell_grid) {
+    int nwords = PACKED_WORDS(master->dimensions.cols);
+    int ncolumnwords = PACKED_COLUMN_WORDS(master->dimensions.rows);
+    int periodic_boundary_start = master->params.landscape / FIRSTPERIODICBOUNDARYDIVISOR + OFFSET;
+    int periodic_boundary_end = (SECONDPERIODICBOUNDARYDIVISOR * master->params.landscape) / FIRSTPERIODICBOUNDARYDIVISOR;
+
+    uint64_t **packed_grid = create_packed_cell_array(master);
+    uint64_t **next_grid = create_packed_cell_array(master);
+    uint64_t *interior_mask = create_packed_buffer(nwords);
+    uint64_t *boundary_mask = create_packed_buffer(nwords);
+    uint64_t *send_left = create_packed_buffer(ncolumnwords);
+    uint64_t *send_right = create_packed_buffer(ncolumnwords);
+    uint64_t *recv_left = create_packed_buffer(ncolumnwords);
+    uint64_t *recv_right = create_packed_buffer(ncolumnwords);
+
+    pack_cells(cell_grid, packed_grid, master);
+    build_interior_mask(interior_mask, master);
+    build_boundary_mask(boundary_mask, periodic_boundary_start, periodic_boundary_end, master);
+
+    int local_live_cells;
+    par_start_timing(master);
+
+    for (int step = master->start_step + 1; step <= master->params.maxstep; step++) {
+        double step_start = gettime();
+        pack_halo_columns(packed_grid, send_left, send_right, master);
+        exchange_packed_halo_cells(packed_grid, send_left, send_right, recv_left, recv_right, nwords, ncolumnwords, master->cart, master);
+        master->time.halo += gettime() - step_start;
+
+        // Columns are not periodic, so the edge processes keep their zero halo columns.
+        if (master->cart.left.val != MPI_PROC_NULL) {
+            unpack_halo_column(packed_grid, recv_left, 0, master);
+        }
+        if (master->cart.right.val != MPI_PROC_NULL) {
+            unpack_halo_column(packed_grid, recv_right, master->dimensions.cols + 1, master);
+        }
+
+        packed_adjust_boundaries(packed_grid, boundary_mask, master->cart, master);
+        packed_update_cells(packed_grid, next_grid, interior_mask, &local_live_cells, master);
+        swap_packed_arrays(&packed_grid, &next_grid);
+        master->time.step += gettime() - step_start;
+        if (report_live_cells(master, local_live_cells, step)) {
+            break;  // Terminate if function returns true
+        }
+    }
+
+    par_stop_timing(master);  // Stop timing and calculate
+
+    if (master->comm.rank == 0) {
+        par_print_timing(master);  // Print the results
+    }
+
+    unpack_cells(packed_grid, cell_grid, master);
+
+    free(packed_grid);
+    free(next_grid);
+    free(interior_mask);
+    free(boundary_mask);
+    free(send_left);
+    free(send_right);
+    free(recv_left);
+    free(recv_right);
+}
+
+#ifdef SIMD
+// Processes the cell data in parallel with the byte-per-cell SIMD engine selected for this CPU
+void par_simd_process(master_str *master, int **cell_grid) {
+    MPI_Datatype column_type, row_type;
+    int periodic_boundary_start = master->params.landscape / FIRSTPERIODICBOUNDARYDIVISOR + OFFSET;
+    int periodic_boundary_end = (SECONDPERIODICBOUNDARYDIVISOR * master->params.landscape) / FIRSTPERIODICBOUNDARYDIVISOR;
+
+    uint8_t **byte_grid = create_byte_cell_array(master);
+    uint8_t **next_grid = create_byte_cell_array(master);
+    uint8_t *boundary_mask = (uint8_t*) malloc(master->dimensions.cols + 2);
+    if (boundary_mask == NULL) {
+        handle_allocation_failure();
+    }
+
+    const char *kernel = select_simd_kernel(master->params.isa, &master->params.rule);
+    if (master->comm.rank == 0) {
+        printf("automaton: simd engine using %s kernel\n", kernel);
+    }
+
+    initialize_byte_mpi_types(&column_type, &row_type, master);
+    pack_byte_cells(cell_grid, byte_grid, master);
+    build_byte_boundary_mask(boundary_mask, periodic_boundary_start, periodic_boundary_end, master);
+
+    int local_live_cells;
+    par_start_timing(master);
+
+    for (int step = master->start_step + 1; step <= master->params.maxstep; step++) {
+        double step_start = gettime();
+        exchange_byte_halo_cells(byte_grid, row_type, column_type, master->cart, master);
+        master->time.halo += gettime() - step_start;
+        byte_adjust_boundaries(byte_grid, boundary_mask, master->cart, master);
+        byte_update_cells(byte_grid, next_grid, &local_live_cells, master);
+        swap_byte_arrays(&byte_grid, &next_grid);
+        master->time.step += gettime() - step_start;
+        if (report_live_cells(master, local_live_cells, step)) {
+            break;  // Terminate if function returns true
+        }
+    }
+
+    par_stop_timing(master);  // Stop timing and calculate
+
+    if (master->comm.rank == 0) {
+        par_print_timing(master);  // Print the results
+    }
+
+    unpack_byte_cells(byte_grid, cell_grid, master);
+
+    MPI_Type_free(&column_type);
+    MPI_Type_free(&row_type);
+    free(byte_grid);
+    free(next_grid);
+    free(boundary_mask);
+}
+#endif
+
 // Gathers data from all processes, combines it, and writes it to a file
-void par_gather_write_data(master_str *master, int **local_cell_grid, int **reduction_cell_grid, int **global_cell_grid, int **cell_grid) {
+void par_gather_write_data(master_str *master, int **local_cell_grid, int **global_cell_grid, int **cell_grid) {
+    double gather_start = gettime();
+
     copy_data_to_local_cell_grid(cell_grid, local_cell_grid, master);
-    zerotmpcell(reduction_cell_grid, master);
-    gather_cells(local_cell_grid, reduction_cell_grid, master);
-    mpi_reduce_allcell(master->cart, reduction_cell_grid, global_cell_grid, master->params.landscape);
+
+    // The binary image is written by every process straight from its tile
+    if (master->params.pbm == pbm_binary && mpwrite_supported(master)) {
+        master->time.gather = 0.0;
+        mpwrite_cells("cell.pbm", local_cell_grid, master->cart, master);
+        master->time.write = gettime() - gather_start;
+        par_print_output_timing(master, "MPI-IO binary");
+        return;
+    }
+
+    mpgather_tiles(master->cart, local_cell_grid, global_cell_grid, master);
+    master->time.gather = gettime() - gather_start;
+    master->time.write = 0.0;
 
     if (master->comm.rank == 0) {
-        writecelldynamic("cell.pbm", global_cell_grid, master->params.landscape);
+        double write_start = gettime();
+        if (master->params.pbm == pbm_binary) {
+            writecellbinary("cell.pbm", global_cell_grid, master->params.landscape);
+        } else {
+            writecelldynamic("cell.pbm", global_cell_grid, master->params.landscape);
+        }
+        master->time.write = gettime() - write_start;
     }
+
+    par_print_output_timing(master, (master->params.pbm == pbm_binary) ? "gathered binary" : "gathered ascii");
+}
+
+// Outputs the time spent collecting and writing the final landscape
+void par_print_output_timing(master_str *master, const char *method) {
+#ifdef TIME
+    double gather_max = mpgmax(master->cart, &master->time.gather);
+    double write_max = mpgmax(master->cart, &master->time.write);
+
+    if (master->comm.rank == 0) {
+        printf("Output gather = %f, write = %f (max over ranks, %s)\n", gather_max, write_max, method);
+    }
+#endif
 }
 
 // Cleans up and deallocates memory, stops MPI communication to prepare for shutdown
-void par_clean_buffers_stop_comm(master_str *master, int **cell_grid, int **neighbor_grid, int **global_cell_grid, int **local_cell_grid, int **reduction_cell_grid) {
-    deallocate_arrays(cell_grid, neighbor_grid, global_cell_grid, local_cell_grid, reduction_cell_grid);
+void par_clean_buffers_stop_comm(master_str *master, int **cell_grid, int **neighbor_grid, int **global_cell_grid, int **local_cell_grid) {
+    deallocate_arrays(cell_grid, neighbor_grid, global_cell_grid, local_cell_grid);
     mpstop();
 }
 
+// Prints the minimum and maximum over the processes of the grid storage and the peak resident memory
+void par_report_memory(master_str *master) {
+    double allocated = allocated_memory_mb();
+    double peak = peak_memory_mb();
+    double allocated_min = mpgmin(master->cart, &allocated);
+    double allocated_max = mpgmax(master->cart, &allocated);
+    double peak_min = mpgmin(master->cart, &peak);
+    double peak_max = mpgmax(master->cart, &peak);
+
+    if (master->comm.rank == 0) {
+        printf("automaton: largest tile = %d x %d, grid memory per rank = %.2f - %.2f MB, peak resident memory per rank = %.2f - %.2f MB\n",
+               master->dimensions.rows, master->dimensions.cols, allocated_min, allocated_max, peak_min, peak_max);
+    }
+}
+
 // Starts the timing for performance evaluation in parallel processing
 void par_start_timing(master_str *master) {
+    master->time.halo = 0.0;
+    master->time.step = 0.0;
+    master->time.reduce = 0.0;
+    memset(&master->snapshot, 0, sizeof(master->snapshot));
+    memset(&master->profile, 0, sizeof(master->profile));
 #ifdef TIME
     MPI_Barrier(master->cart.comm2d);
-    master->time.start = gettime();
 #endif
+    master->time.start = gettime();
 }
 
 // Stops the timing and calculates the average processing time across all processes
@@ -108,6 +674,8 @@ void par_stop_timing(master_str *master) {
     MPI_Barrier(master->cart.comm2d);
     master->time.local = gettime() - master->time.start;
     master->time.average = mpgsum(master->cart, &master->time.local) / master->comm.size;
+    master->time.halo_average = mpgsum(master->cart, &master->time.halo) / master->comm.size;
+    master->time.step_average = mpgsum(master->cart, &master->time.step) / master->comm.size;
 #endif
 }
 
@@ -115,5 +683,7 @@ void par_stop_timing(master_str *master) {
 void par_print_timing(master_str *master) {
 #ifdef TIME
     printf("Average Time for %d iterations = %f\n", master->params.maxstep, master->time.average);
+    printf("Average halo wait = %f, average exchange and compute = %f (%s)\n",
+           master->time.halo_average, master->time.step_average, master->params.overlap ? "overlapped" : "blocking");
 #endif
 }
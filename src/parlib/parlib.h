@@ -13,13 +13,30 @@ void par_initialise_buffers(master_str *master);
 void par_initialise_and_distribute(master_str *master, int **cell_grid, int **global_cell_grid, int **local_cell_grid, int live_cells);
 
 // Processes cell data in parallel, modifying cell states based on neighbor interactions
-void par_process(master_str *master, int **cell_grid, int **neighbor_grid);
+void par_process(master_str *master, int ***cell_grid, int ***neighbor_grid);
+
+// Processes cell data in parallel exchanging deep halos once every -halo steps
+void par_deep_halo_process(master_str *master, int **cell_grid);
+
+// Processes cell data in parallel using the bit-packed engine
+void par_bit_process(master_str *master, int **cell_grid);
+
+#ifdef SIMD
+// Processes cell data in parallel using the byte-per-cell SIMD engine
+void par_simd_process(master_str *master, int **cell_grid);
+#endif
 
 // Gathers data from parallel computation nodes and writes it to files or other outputs
-void par_gather_write_data(master_str *master, int **local_cell_grid, int **reduction_cell_grid, int **global_cell_grid, int **cell_grid);
+void par_gather_write_data(master_str *master, int **local_cell_grid, int **global_cell_grid, int **cell_grid);
+
+// Prints the time spent collecting and writing the final landscape when timing is enabled
+void par_print_output_timing(master_str *master, const char *method);
 
 // Cleans up buffers and stops communications in a parallel environment, preparing for shutdown
-void par_clean_buffers_stop_comm(master_str *master, int **cell_grid, int **neighbor_grid, int **global_cell_grid, int **local_cell_grid, int **reduction_cell_grid);
+void par_clean_buffers_stop_comm(master_str *master, int **cell_grid, int **neighbor_grid, int **global_cell_grid, int **local_cell_grid);
+
+// Prints the range over the processes of the grid storage and peak resident memory per process
+void par_report_memory(master_str *master);
 
 // Starts timing for performance measurement in parallel computation
 void par_start_timing(master_str *master);
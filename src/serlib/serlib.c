@@ -11,6 +11,11 @@
 #include "serlib.h"
 #include "mem.h"
 #include "misc.h"
+#include "bitlib.h"
+#include "hashlib.h"
+#ifdef SIMD
+#include "simdlib.h"
+#endif
 
 #define FIRSTPERIODICBOUNDARYDIVISOR 8
 #define SECONDPERIODICBOUNDARYDIVISOR 7
@@ -33,28 +38,210 @@ int ser_read_args(int argc, char **argv, master_str *master) {
 
 // Initializes and distributes cells across the processes
 void ser_initialise_and_distribute(master_str *master, int **cell_grid, int **global_cell_grid, int **local_cell_grid, int live_cells) {
-    printf("automaton: running on %d process(es)\n", master->comm.size);
+    printf("automaton: running on %d process(es), %d thread(s) each\n", master->comm.size, master->params.threads);
     printf("automaton: L = %d, rho = %f, seed = %d, maxstep = %d\n",
            master->params.landscape, master->params.rho, master->params.seed, master->params.maxstep);
-    rinit(master->params.seed);
-    initialize_cells(master->params.landscape, global_cell_grid, master, &live_cells);
-    copy_data_to_cell_grid(cell_grid, global_cell_grid, master);
+    report_rule(master);
+    if (master->params.restart != NULL) {
+        live_cells = mpread_checkpoint(master->params.restart, cell_grid, master->cart, master);
+        printf("automaton: live cells = %d after step %d\n", live_cells, master->start_step);
+    } else if (master->params.init == counter_init) {
+        initialize_tile_cells(cell_grid, master, &live_cells);
+        report_initial_cells(master, live_cells);
+    } else {
+        rinit(master->params.seed);
+        initialize_cells(master->params.landscape, global_cell_grid, master, &live_cells);
+        copy_data_to_cell_grid(cell_grid, global_cell_grid, master);
+    }
     zero_top_bottom_halos(cell_grid, master);
     zero_left_right_halos(cell_grid, master);
 }
 
-// Processes cells, calculating and updating their states
-void ser_process(master_str *master, int **cell_grid, int **neighbor_grid) {
+// Processes cells, calculating and updating their states. The fused engine writes each generation
+// into neighbor_grid and swaps it with cell_grid, so both pointers may be exchanged on return.
+void ser_process(master_str *master, int ***cell_grid, int ***neighbor_grid) {
     int live_cell_count; 
+    active_str active;
+    int edges[4];
+    if (master->params.engine == fused_engine) {
+        zero_top_bottom_halos(*neighbor_grid, master);
+        zero_left_right_halos(*neighbor_grid, master);
+    }
+    if (master->params.active) {
+        create_active_blocks(&active, master);
+    }
     ser_start_timing(master);
-    for (int step = 1; step <= master->params.maxstep; step++) {
+    for (int step = master->start_step + 1; step <= master->params.maxstep; step++) {
         // Improved variable names for clarity
         int periodic_boundary_start = master->params.landscape / FIRSTPERIODICBOUNDARYDIVISOR + OFFSET;
         int periodic_boundary_end = (SECONDPERIODICBOUNDARYDIVISOR * master->params.landscape) / FIRSTPERIODICBOUNDARYDIVISOR;
-        ser_periodic_boundary(cell_grid, master);
-        ser_boundary_conditions(cell_grid, master->cart, periodic_boundary_start, periodic_boundary_end, master);
-        calculate_neighbors(cell_grid, neighbor_grid, master);
-        update_cells(cell_grid, neighbor_grid, &live_cell_count, master);
+        ser_periodic_boundary(*cell_grid, master);
+        ser_boundary_conditions(*cell_grid, master->cart, periodic_boundary_start, periodic_boundary_end, master);
+        if (master->params.active) {
+            // The periodic top and bottom halos are copies of the bottom and top rows.
+            active_edges(&active, edges);
+            int halos[4] = {edges[0], edges[1], 0, 0};
+            live_cell_count = update_cells_active(*cell_grid, *neighbor_grid, halos, &active, master);
+            swap_arrays(cell_grid, neighbor_grid);
+        } else if (master->params.engine == fused_engine) {
+            update_cells_fused(*cell_grid, *neighbor_grid, &live_cell_count, master);
+            swap_arrays(cell_grid, neighbor_grid);
+        } else {
+            calculate_neighbors(*cell_grid, *neighbor_grid, master);
+            update_cells(*cell_grid, *neighbor_grid, &live_cell_count, master);
+        }
+        take_snapshot(*cell_grid, step, master);
+        take_checkpoint(*cell_grid, step, master);
+        if (step % master->params.printfreq == 0) {
+            printf("automaton: number of live cells on step %d is %d\n", step, live_cell_count);
+        }
+        bool terminate = should_terminate(live_cell_count, master, step);
+        if (master->params.active && (step % master->params.printfreq == 0 || terminate)) {
+            report_active_blocks(&active, step, master);
+        }
+        if (terminate) {
+            break;  // Terminate if function returns true
+        }
+    }
+    if (master->params.active) {
+        free_active_blocks(&active);
+    }
+    finish_snapshots(master);
+    ser_stop_timing(master);  // Stop timing and calculate
+    ser_print_timing(master);  // Print the results
+}
+
+// Processes cells with the bit-packed engine, updating 64 cells per word
+void ser_bit_process(master_str *master, int **cell_grid) {
+    int live_cell_count;
+    int nwords = PACKED_WORDS(master->dimensions.cols);
+    int periodic_boundary_start = master->params.landscape / FIRSTPERIODICBOUNDARYDIVISOR + OFFSET;
+    int periodic_boundary_end = (SECONDPERIODICBOUNDARYDIVISOR * master->params.landscape) / FIRSTPERIODICBOUNDARYDIVISOR;
+
+    uint64_t **packed_grid = create_packed_cell_array(master);
+    uint64_t **next_grid = create_packed_cell_array(master);
+    uint64_t *interior_mask = create_packed_buffer(nwords);
+    uint64_t *boundary_mask = create_packed_buffer(nwords);
+
+    pack_cells(cell_grid, packed_grid, master);
+    build_interior_mask(interior_mask, master);
+    build_boundary_mask(boundary_mask, periodic_boundary_start, periodic_boundary_end, master);
+
+    ser_start_timing(master);
+    for (int step = master->start_step + 1; step <= master->params.maxstep; step++) {
+        packed_periodic_boundary(packed_grid, boundary_mask, master);
+        packed_update_cells(packed_grid, next_grid, interior_mask, &live_cell_count, master);
+        swap_packed_arrays(&packed_grid, &next_grid);
+        if (step % master->params.printfreq == 0) {
+            printf("automaton: number of live cells on step %d is %d\n", step, live_cell_count);
+        }
+        if (should_terminate(live_cell_count, master, step)) {
+            break;  // Terminate if function returns true
+        }
+    }
+    ser_stop_timing(master);  // Stop timing and calculate
+    ser_print_timing(master);  // Print the results
+
+    unpack_cells(packed_grid, cell_grid, master);
+
+    free(packed_grid);
+    free(next_grid);
+    free(interior_mask);
+    free(boundary_mask);
+}
+
+// Processes an ensemble of independent replicas, bit k of every cell word being replica k, so that
+// one bit-sliced update advances them all. Each replica stops on its own when its live cells leave
+// the termination thresholds, and the run ends when all have stopped. Replica 0 is returned in
+// cell_grid for the final image.
+void ser_ensemble_process(master_str *master, int **cell_grid) {
+    int replicas = master->params.ensemble;
+    int initial_cells[MAXREPLICAS];
+    int live_cells[MAXREPLICAS];
+    int last_step[MAXREPLICAS];
+    uint64_t running = (replicas == MAXREPLICAS) ? ~(uint64_t) 0 : ((uint64_t) 1 << replicas) - 1;
+    int periodic_boundary_start = master->params.landscape / FIRSTPERIODICBOUNDARYDIVISOR + OFFSET;
+    int periodic_boundary_end = (SECONDPERIODICBOUNDARYDIVISOR * master->params.landscape) / FIRSTPERIODICBOUNDARYDIVISOR;
+
+    uint64_t **ensemble_grid = create_ensemble_cell_array(master);
+    uint64_t **next_grid = create_ensemble_cell_array(master);
+
+    initialize_ensemble_cells(ensemble_grid, initial_cells, master);
+    for (int k = 0; k < replicas; k++) {
+        printf("automaton: replica %d, seed = %d, rho = %f, live cells = %d\n", k, master->params.seed + k * master->params.seedstep,
+               master->params.rho + k * master->params.rhostep, initial_cells[k]);
+        last_step[k] = master->params.maxstep;
+    }
+
+    ser_start_timing(master);
+    for (int step = master->start_step + 1; step <= master->params.maxstep && running != 0; step++) {
+        ensemble_periodic_boundary(ensemble_grid, periodic_boundary_start, periodic_boundary_end, master);
+        ensemble_update_cells(ensemble_grid, next_grid, running, live_cells, master);
+        swap_packed_arrays(&ensemble_grid, &next_grid);
+        for (int k = 0; k < replicas; k++) {
+            if (!((running >> k) & 1)) {
+                continue;
+            }
+            if (step % master->params.printfreq == 0) {
+                printf("automaton: replica %d, number of live cells on step %d is %d\n", k, step, live_cells[k]);
+            }
+            if (out_of_threshold_range(live_cells[k], initial_cells[k])) {
+                printf("Terminating replica %d early: number of live cells out of threshold range on step %d\n", k, step);
+                running &= ~((uint64_t) 1 << k);
+                last_step[k] = step;
+            }
+        }
+    }
+    ser_stop_timing(master);  // Stop timing and calculate
+    ser_print_timing(master);  // Print the results
+
+    for (int k = 0; k < replicas; k++) {
+        printf("automaton: replica %d, %d live cells after step %d\n", k, live_cells[k], last_step[k]);
+    }
+    unpack_ensemble_replica(ensemble_grid, cell_grid, 0, master);
+
+    free(ensemble_grid);
+    free(next_grid);
+}
+
+// Processes cells with the hash engine, which jumps from one print step to the next through the
+// memoised evolution of the squares of the landscape instead of computing every step. The live
+// cells are only known at the end of each jump, so when they are out of the termination thresholds
+// there the jump is replayed step by step with the fused kernel from the copy of its start kept in
+// saved_grid, to find the step they left them on. A landscape that leaves the thresholds and comes
+// back within a jump is not stopped, as in the parallel version, which checks them on the print
+// steps only; the serial engines, which check every step, would stop it.
+void ser_hash_process(master_str *master, int **cell_grid, int **saved_grid) {
+    int live_cell_count;
+    int periodic_boundary_start = master->params.landscape / FIRSTPERIODICBOUNDARYDIVISOR + OFFSET;
+    int periodic_boundary_end = (SECONDPERIODICBOUNDARYDIVISOR * master->params.landscape) / FIRSTPERIODICBOUNDARYDIVISOR;
+    hash_str hash;
+
+    hash_init(&hash, periodic_boundary_start, periodic_boundary_end, master);
+
+    ser_start_timing(master);
+    int step = master->start_step;
+    while (step < master->params.maxstep) {
+        int target = (step / master->params.printfreq + 1) * master->params.printfreq;
+        if (target > master->params.maxstep) {
+            target = master->params.maxstep;
+        }
+        copy_interior_cells(cell_grid, saved_grid, master);
+        live_cell_count = hash_advance(&hash, cell_grid, target - step, master);
+        if (master->params.bench == 0 && out_of_threshold_range(live_cell_count, master->initialcells)) {
+            copy_interior_cells(saved_grid, cell_grid, master);
+            for (int s = step + 1; s <= target; s++) {
+                ser_periodic_boundary(cell_grid, master);
+                ser_boundary_conditions(cell_grid, master->cart, periodic_boundary_start, periodic_boundary_end, master);
+                update_cells_fused(cell_grid, saved_grid, &live_cell_count, master);
+                copy_interior_cells(saved_grid, cell_grid, master);
+                if (out_of_threshold_range(live_cell_count, master->initialcells)) {
+                    target = s;
+                    break;
+                }
+            }
+        }
+        step = target;
         if (step % master->params.printfreq == 0) {
             printf("automaton: number of live cells on step %d is %d\n", step, live_cell_count);
         }
@@ -64,24 +251,81 @@ void ser_process(master_str *master, int **cell_grid, int **neighbor_grid) {
     }
     ser_stop_timing(master);  // Stop timing and calculate
     ser_print_timing(master);  // Print the results
+
+    printf("automaton: hash engine took %d jumps of up to %d steps, %zu nodes held, tables emptied %d times\n",
+           hash.jumps, hash.longest, hash.nodes, hash.clears);
+    hash_free(&hash);
 }
 
+#ifdef SIMD
+// Processes cells with the byte-per-cell SIMD engine selected for this CPU
+void ser_simd_process(master_str *master, int **cell_grid) {
+    int live_cell_count;
+    int periodic_boundary_start = master->params.landscape / FIRSTPERIODICBOUNDARYDIVISOR + OFFSET;
+    int periodic_boundary_end = (SECONDPERIODICBOUNDARYDIVISOR * master->params.landscape) / FIRSTPERIODICBOUNDARYDIVISOR;
 
+    uint8_t **byte_grid = create_byte_cell_array(master);
+    uint8_t **next_grid = create_byte_cell_array(master);
+    uint8_t *boundary_mask = (uint8_t*) malloc(master->dimensions.cols + 2);
+    if (boundary_mask == NULL) {
+        handle_allocation_failure();
+    }
+
+    printf("automaton: simd engine using %s kernel\n", select_simd_kernel(master->params.isa, &master->params.rule));
+    pack_byte_cells(cell_grid, byte_grid, master);
+    build_byte_boundary_mask(boundary_mask, periodic_boundary_start, periodic_boundary_end, master);
+
+    ser_start_timing(master);
+    for (int step = master->start_step + 1; step <= master->params.maxstep; step++) {
+        byte_periodic_boundary(byte_grid, boundary_mask, master);
+        byte_update_cells(byte_grid, next_grid, &live_cell_count, master);
+        swap_byte_arrays(&byte_grid, &next_grid);
+        if (step % master->params.printfreq == 0) {
+            printf("automaton: number of live cells on step %d is %d\n", step, live_cell_count);
+        }
+        if (should_terminate(live_cell_count, master, step)) {
+            break;  // Terminate if function returns true
+        }
+    }
+    ser_stop_timing(master);  // Stop timing and calculate
+    ser_print_timing(master);  // Print the results
+
+    unpack_byte_cells(byte_grid, cell_grid, master);
+
+    free(byte_grid);
+    free(next_grid);
+    free(boundary_mask);
+}
+#endif
 
 // Gathers and writes data to a file
-void ser_gather_write_data(master_str *master, int **local_cell_grid, int **reduction_cell_grid, int **global_cell_grid, int **cell_grid) {
+void ser_gather_write_data(master_str *master, int **local_cell_grid, int **global_cell_grid, int **cell_grid) {
     copy_data_to_local_cell_grid(cell_grid, global_cell_grid, master);
     if (master->comm.rank == 0) {
-        writecelldynamic("cell.pbm", global_cell_grid, master->params.landscape);
+        double write_start = gettime();
+        if (master->params.pbm == pbm_binary) {
+            writecellbinary("cell.pbm", global_cell_grid, master->params.landscape);
+        } else {
+            writecelldynamic("cell.pbm", global_cell_grid, master->params.landscape);
+        }
+        master->time.write = gettime() - write_start;
+#ifdef TIME
+        printf("Output write = %f (%s)\n", master->time.write, (master->params.pbm == pbm_binary) ? "binary" : "ascii");
+#endif
     }
 }
 
 // Cleans up and deallocates all arrays and stops communication
-void ser_clean_buffers_stop_comm(master_str *master, int **cell_grid, int **neighbor_grid, int **global_cell_grid, int **local_cell_grid, int **reduction_cell_grid) {
-    deallocate_arrays(cell_grid, neighbor_grid, global_cell_grid, local_cell_grid, reduction_cell_grid);
+void ser_clean_buffers_stop_comm(master_str *master, int **cell_grid, int **neighbor_grid, int **global_cell_grid, int **local_cell_grid) {
+    deallocate_arrays(cell_grid, neighbor_grid, global_cell_grid, local_cell_grid);
     mpstop();
 }
 
+// Prints the grid storage and the peak resident memory of the process
+void ser_report_memory(master_str *master) {
+    printf("automaton: grid memory = %.2f MB, peak resident memory = %.2f MB\n", allocated_memory_mb(), peak_memory_mb());
+}
+
 // Enforces periodic boundary conditions on the cellular grid
 void ser_periodic_boundary(int **cell_grid, master_str *master) {
     for (int j = 1; j <= master->params.landscape; j++) {
@@ -102,10 +346,14 @@ void ser_boundary_conditions(int **cell_grid, cart_str cart, int periodic_bounda
 
 // Starts timing for performance analysis
 void ser_start_timing(master_str *master) {
+    master->time.halo = 0.0;
+    master->time.step = 0.0;
+    master->time.reduce = 0.0;
+    memset(&master->snapshot, 0, sizeof(master->snapshot));
 #ifdef TIME
     MPI_Barrier(master->cart.comm2d);
-    master->time.start = gettime();
 #endif
+    master->time.start = gettime();
 }
 
 // Stops timing and calculates average time
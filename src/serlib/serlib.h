@@ -16,13 +16,30 @@ void ser_initialise_buffers(master_str *master);
 void ser_initialise_and_distribute(master_str *master, int **cell_grid, int **global_cell_grid, int **local_cell_grid, int live_cells);
 
 // Processes cell data in a serial manner, modifying cell states based on neighbor interactions
-void ser_process(master_str *master, int **cell_grid, int **neighbor_grid);
+void ser_process(master_str *master, int ***cell_grid, int ***neighbor_grid);
+
+// Processes cell data in a serial manner using the bit-packed engine
+void ser_bit_process(master_str *master, int **cell_grid);
+
+// Processes an ensemble of replicas with different seeds and densities, one bit of each cell word per replica
+void ser_ensemble_process(master_str *master, int **cell_grid);
+
+// Processes cell data in a serial manner with the memoised quadtree of the hash engine, jumping between print steps, saved_grid being scratch
+void ser_hash_process(master_str *master, int **cell_grid, int **saved_grid);
+
+#ifdef SIMD
+// Processes cell data in a serial manner using the byte-per-cell SIMD engine
+void ser_simd_process(master_str *master, int **cell_grid);
+#endif
 
 // Gathers data from serial computation and writes it to files or other outputs
-void ser_gather_write_data(master_str *master, int **local_cell_grid, int **reduction_cell_grid, int **global_cell_grid, int **cell_grid);
+void ser_gather_write_data(master_str *master, int **local_cell_grid, int **global_cell_grid, int **cell_grid);
 
 // Cleans up buffers and stops communications, preparing for shutdown in a serial environment
-void ser_clean_buffers_stop_comm(master_str *master, int **cell_grid, int **neighbor_grid, int **global_cell_grid, int **local_cell_grid, int **reduction_cell_grid);
+void ser_clean_buffers_stop_comm(master_str *master, int **cell_grid, int **neighbor_grid, int **global_cell_grid, int **local_cell_grid);
+
+// Prints the grid storage and peak resident memory of the process
+void ser_report_memory(master_str *master);
 
 // Starts timing for performance measurement in serial computation
 void ser_start_timing(master_str *master);
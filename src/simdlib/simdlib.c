@@ -0,0 +1,214 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "structs.h"
+#include "simdlib.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define X86
+#endif
+
+// New state of a cell indexed by its five-point neighbourhood sum (0..5), filled from the rule.
+static uint8_t rule_table[16];
+
+// Sums the SSE2 kernel compares against and whether they are those of dead cells.
+static int rule_count;
+static uint8_t rule_members[RULE_MEMBERS];
+static uint8_t rule_invert;
+
+// Computes the next state of the interior cells 1..cols of one row and returns the number of live cells.
+typedef int (*row_kernel)(const uint8_t *up, const uint8_t *row, const uint8_t *down, uint8_t *next, int cols);
+
+// Scalar update of the cells first..cols of a row, used as the fallback and for the vector remainders.
+static int row_tail_scalar(const uint8_t *up, const uint8_t *row, const uint8_t *down, uint8_t *next, int first, int cols) {
+    int live_cells = 0;
+    for (int j = first; j <= cols; j++) {
+        uint8_t alive = rule_table[row[j] + up[j] + down[j] + row[j - 1] + row[j + 1]];
+        next[j] = alive;
+        live_cells += alive;
+    }
+    return live_cells;
+}
+
+static int row_kernel_scalar(const uint8_t *up, const uint8_t *row, const uint8_t *down, uint8_t *next, int cols) {
+    return row_tail_scalar(up, row, down, next, 1, cols);
+}
+
+#ifdef X86
+
+// SSE2 has no byte shuffle, so the sum is compared against the members of the rule directly.
+__attribute__((target("sse2")))
+static int row_kernel_sse2(const uint8_t *up, const uint8_t *row, const uint8_t *down, uint8_t *next, int cols) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i invert = _mm_set1_epi8(rule_invert);
+    __m128i members[RULE_MEMBERS];
+    __m128i count = _mm_setzero_si128();
+    int j = 1;
+
+    for (int m = 0; m < rule_count; m++) {
+        members[m] = _mm_set1_epi8(rule_members[m]);
+    }
+
+    for (; j + 15 <= cols; j += 16) {
+        __m128i sum = _mm_add_epi8(_mm_loadu_si128((const __m128i *) (row + j)), _mm_loadu_si128((const __m128i *) (up + j)));
+        sum = _mm_add_epi8(sum, _mm_loadu_si128((const __m128i *) (down + j)));
+        sum = _mm_add_epi8(sum, _mm_loadu_si128((const __m128i *) (row + j - 1)));
+        sum = _mm_add_epi8(sum, _mm_loadu_si128((const __m128i *) (row + j + 1)));
+
+        __m128i alive = zero;
+        for (int m = 0; m < rule_count; m++) {
+            alive = _mm_or_si128(alive, _mm_cmpeq_epi8(sum, members[m]));
+        }
+        alive = _mm_xor_si128(_mm_and_si128(alive, one), invert);
+        _mm_storeu_si128((__m128i *) (next + j), alive);
+
+        // Sum of absolute differences against zero adds the bytes into two 64-bit lanes.
+        count = _mm_add_epi64(count, _mm_sad_epu8(alive, zero));
+    }
+
+    int live_cells = _mm_cvtsi128_si32(count) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(count, count));
+    return live_cells + row_tail_scalar(up, row, down, next, j, cols);
+}
+
+// AVX2 looks the sums up in rule_table with a byte shuffle, which works per 128-bit lane.
+__attribute__((target("avx2")))
+static int row_kernel_avx2(const uint8_t *up, const uint8_t *row, const uint8_t *down, uint8_t *next, int cols) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i table = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) rule_table));
+    __m256i count = _mm256_setzero_si256();
+    int j = 1;
+
+    for (; j + 31 <= cols; j += 32) {
+        __m256i sum = _mm256_add_epi8(_mm256_loadu_si256((const __m256i *) (row + j)), _mm256_loadu_si256((const __m256i *) (up + j)));
+        sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *) (down + j)));
+        sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *) (row + j - 1)));
+        sum = _mm256_add_epi8(sum, _mm256_loadu_si256((const __m256i *) (row + j + 1)));
+
+        __m256i alive = _mm256_shuffle_epi8(table, sum);
+        _mm256_storeu_si256((__m256i *) (next + j), alive);
+        count = _mm256_add_epi64(count, _mm256_sad_epu8(alive, zero));
+    }
+
+    __m128i half = _mm_add_epi64(_mm256_castsi256_si128(count), _mm256_extracti128_si256(count, 1));
+    int live_cells = _mm_cvtsi128_si32(half) + _mm_cvtsi128_si32(_mm_unpackhi_epi64(half, half));
+    return live_cells + row_tail_scalar(up, row, down, next, j, cols);
+}
+
+// AVX-512BW is the AVX2 kernel on 64 cells at a time.
+__attribute__((target("avx512f,avx512bw")))
+static int row_kernel_avx512(const uint8_t *up, const uint8_t *row, const uint8_t *down, uint8_t *next, int cols) {
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i table = _mm512_broadcast_i32x4(_mm_loadu_si128((const __m128i *) rule_table));
+    __m512i count = _mm512_setzero_si512();
+    int j = 1;
+
+    for (; j + 63 <= cols; j += 64) {
+        __m512i sum = _mm512_add_epi8(_mm512_loadu_si512(row + j), _mm512_loadu_si512(up + j));
+        sum = _mm512_add_epi8(sum, _mm512_loadu_si512(down + j));
+        sum = _mm512_add_epi8(sum, _mm512_loadu_si512(row + j - 1));
+        sum = _mm512_add_epi8(sum, _mm512_loadu_si512(row + j + 1));
+
+        __m512i alive = _mm512_shuffle_epi8(table, sum);
+        _mm512_storeu_si512(next + j, alive);
+        count = _mm512_add_epi64(count, _mm512_sad_epu8(alive, zero));
+    }
+
+    int live_cells = (int) _mm512_reduce_add_epi64(count);
+    return live_cells + row_tail_scalar(up, row, down, next, j, cols);
+}
+
+#endif // X86
+
+static row_kernel selected_kernel = row_kernel_scalar;
+
+// Pick the row kernel once at startup from the CPUID feature flags and load the rule into its tables.
+const char *select_simd_kernel(isa requested, const rule_str *rule) {
+    memset(rule_table, 0, sizeof(rule_table));
+    memcpy(rule_table, rule->alive, 6);
+    rule_count = rule->count;
+    for (int m = 0; m < rule->count; m++) {
+        rule_members[m] = (uint8_t) rule->members[m];
+    }
+    rule_invert = (uint8_t) rule->invert;
+
+    selected_kernel = row_kernel_scalar;
+#ifdef X86
+    __builtin_cpu_init();
+    if ((requested == isa_auto || requested >= isa_avx512) && __builtin_cpu_supports("avx512bw")) {
+        selected_kernel = row_kernel_avx512;
+        return "avx512";
+    }
+    if ((requested == isa_auto || requested >= isa_avx2) && __builtin_cpu_supports("avx2")) {
+        selected_kernel = row_kernel_avx2;
+        return "avx2";
+    }
+    if ((requested == isa_auto || requested >= isa_sse2) && __builtin_cpu_supports("sse2")) {
+        selected_kernel = row_kernel_sse2;
+        return "sse2";
+    }
+#endif
+    return "scalar";
+}
+
+// Copy the padded int cell grid, halos included, into the byte grid.
+void pack_byte_cells(int **cell_grid, uint8_t **byte_grid, master_str *master) {
+    for (int i = 0; i <= master->dimensions.rows + 1; i++) {
+        for (int j = 0; j <= master->dimensions.cols + 1; j++) {
+            byte_grid[i][j] = (uint8_t) cell_grid[i][j];
+        }
+    }
+}
+
+// Copy the interior of the byte grid back into the padded int cell grid.
+void unpack_byte_cells(uint8_t **byte_grid, int **cell_grid, master_str *master) {
+    for (int i = 1; i <= master->dimensions.rows; i++) {
+        for (int j = 1; j <= master->dimensions.cols; j++) {
+            cell_grid[i][j] = byte_grid[i][j];
+        }
+    }
+}
+
+// Mark the columns whose global index lies inside the periodic boundary band.
+void build_byte_boundary_mask(uint8_t *boundary_mask, int periodic_boundary_start, int periodic_boundary_end, master_str *master) {
+    memset(boundary_mask, 0, master->dimensions.cols + 2);
+    for (int j = 1; j <= master->dimensions.cols; j++) {
+        int index = master->dimensions.first_col + j;
+        boundary_mask[j] = (index >= periodic_boundary_start && index <= periodic_boundary_end);
+    }
+}
+
+// Copy the opposite edge rows into the top and bottom halos, keeping only the periodic band.
+void byte_periodic_boundary(uint8_t **byte_grid, uint8_t *boundary_mask, master_str *master) {
+    int rows = master->dimensions.rows;
+    for (int j = 1; j <= master->dimensions.cols; j++) {
+        byte_grid[0][j] = byte_grid[rows][j] & boundary_mask[j];
+        byte_grid[rows + 1][j] = byte_grid[1][j] & boundary_mask[j];
+    }
+}
+
+// Clear the received top and bottom halo cells outside the periodic band on the edge processes.
+void byte_adjust_boundaries(uint8_t **byte_grid, uint8_t *boundary_mask, cart_str cart, master_str *master) {
+    if (cart.coords[0] == 0) {
+        for (int j = 1; j <= master->dimensions.cols; j++) {
+            byte_grid[0][j] &= boundary_mask[j];
+        }
+    }
+    if (cart.coords[0] == cart.dims[0] - 1) {
+        for (int j = 1; j <= master->dimensions.cols; j++) {
+            byte_grid[master->dimensions.rows + 1][j] &= boundary_mask[j];
+        }
+    }
+}
+
+// Compute the next generation of every interior cell into next_grid and count the live cells.
+void byte_update_cells(uint8_t **byte_grid, uint8_t **next_grid, int *local_live_cells, master_str *master) {
+    int live_cells = 0;
+    #pragma omp parallel for schedule(static) reduction(+:live_cells)
+    for (int i = 1; i <= master->dimensions.rows; i++) {
+        live_cells += selected_kernel(byte_grid[i - 1], byte_grid[i], byte_grid[i + 1], next_grid[i], master->dimensions.cols);
+    }
+    *local_live_cells = live_cells;
+}
@@ -0,0 +1,29 @@
+#ifndef SIMDLIB_H
+#define SIMDLIB_H
+
+#include <stdint.h>
+#include "structs.h"  // Including necessary structures like master_str
+
+// Selects the widest instruction set supported by the CPU, capped by the requested one,
+// and returns its name for reporting
+const char *select_simd_kernel(isa requested, const rule_str *rule);
+
+// Copies the padded int cell grid (including halos) into the byte-per-cell grid
+void pack_byte_cells(int **cell_grid, uint8_t **byte_grid, master_str *master);
+
+// Copies the interior of the byte-per-cell grid back into the padded int cell grid
+void unpack_byte_cells(uint8_t **byte_grid, int **cell_grid, master_str *master);
+
+// Builds the per-column mask (1 or 0) of the columns inside the periodic boundary band
+void build_byte_boundary_mask(uint8_t *boundary_mask, int periodic_boundary_start, int periodic_boundary_end, master_str *master);
+
+// Applies the periodic and fixed top/bottom boundary conditions to a byte grid in the serial version
+void byte_periodic_boundary(uint8_t **byte_grid, uint8_t *boundary_mask, master_str *master);
+
+// Applies the fixed top/bottom boundary conditions to a byte grid in the parallel version
+void byte_adjust_boundaries(uint8_t **byte_grid, uint8_t *boundary_mask, cart_str cart, master_str *master);
+
+// Computes the next generation of the byte grid into next_grid with the selected kernel and counts the live cells
+void byte_update_cells(uint8_t **byte_grid, uint8_t **next_grid, int *local_live_cells, master_str *master);
+
+#endif // SIMDLIB_H
@@ -2,11 +2,54 @@
 #include <stdlib.h>
 #include <string.h>
 #include "structs.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #define RHO 0.51
 #define PRINTFREQ 500
 #define LANDSCAPE 1152
 #define STEP_MULTIPLIER 10
+#define TEMPORAL_DEPTH 16
+#define RULE "2,4,5"
+
+// Set the live sums of the rule from a comma-separated list such as 2,4,5. Returns 1 on a malformed list.
+static int parse_rule(const char *text, rule_str *rule) {
+    memset(rule->alive, 0, sizeof(rule->alive));
+    while (*text != '\0') {
+        if (*text < '0' || *text > '9' || (text[1] != ',' && text[1] != '\0')) {
+            return 1;
+        }
+        rule->alive[*text - '0'] = 1;
+        text += (text[1] == ',') ? 2 : 1;
+    }
+    return 0;
+}
+
+// Choose the sums the kernels compare against: the live sums, or the dead ones when there are fewer,
+// so that at most RULE_MEMBERS comparisons decide any rule. Returns 1 if a live sum is out of range.
+static int compile_rule(rule_str *rule) {
+    int nsums = (rule->neighbourhood == moore) ? 10 : 6;
+    int live = 0;
+
+    for (int s = 0; s < RULE_SUMS; s++) {
+        if (rule->alive[s] && s >= nsums) {
+            return 1;
+        }
+        live += rule->alive[s];
+    }
+    rule->invert = (live > nsums - live);
+    rule->count = 0;
+    for (int s = 0; s < nsums; s++) {
+        if (rule->alive[s] != rule->invert) {
+            rule->members[rule->count++] = s;
+        }
+    }
+    for (int m = rule->count; m < RULE_MEMBERS; m++) {
+        rule->members[m] = -1;
+    }
+    return 0;
+}
 
 // Reads parameters from command-line arguments and initializes them into the master structure
 int read_parameters(master_str *master, int argc, char **argv) {
@@ -14,7 +57,7 @@ int read_parameters(master_str *master, int argc, char **argv) {
     if (argc < 2) {
         // Only the master node outputs the usage message
         if (master->comm.rank == 0) {
-            printf("Usage: automaton <seed> [-rho value] [-printfreq value] [-landscape value] [-maxstep value]\n");
+            printf("Usage: automaton <seed> [-rho value] [-printfreq value] [-landscape value] [-maxstep value] [-rule sums] [-neighbourhood vonneumann|moore] [-engine fused|int|bit|simd|temporal|hash] [-isa auto|scalar|sse2|avx2|avx512] [-overlap] [-exchange persistent|message|neighbour|shared|rma] [-active] [-halo depth] [-init uni|counter] [-pbm binary|ascii] [-snapfreq value] [-checkpoint value] [-restart file] [-threads value] [-profile] [-reorder] [-bench trials] [-benchfile file] [-ensemble replicas] [-seedstep value] [-rhostep value]\n");
         }
         return 1;  // Return 1 to indicate failure due to insufficient arguments
     }
@@ -25,6 +68,27 @@ int read_parameters(master_str *master, int argc, char **argv) {
     master->params.printfreq = PRINTFREQ;      // Default print frequency
     master->params.landscape = LANDSCAPE;     // Default landscape size
     master->params.maxstep = STEP_MULTIPLIER * master->params.landscape;  // Default number of steps
+    parse_rule(RULE, &master->params.rule);   // Alive for neighbourhood sums 2, 4 and 5
+    master->params.rule.neighbourhood = von_neumann;  // The cell and its four orthogonal neighbours
+    master->params.engine = fused_engine;     // Default engine
+    master->params.isa = isa_auto;            // Widest instruction set supported by the CPU
+    master->params.overlap = 0;               // Blocking halo exchange before computing
+    master->params.exchange = persistent_exchange; // Halo requests created once and started every step
+    master->params.active = 0;                // Compute every cell on every step
+    master->params.halo = 1;                  // Exchange one halo cell every step
+    master->params.init = uni_init;           // Rank 0 generates and broadcasts the landscape
+    master->params.pbm = pbm_binary;          // Bit-packed P4 image written by all ranks
+    master->params.snapfreq = 0;              // No in-run snapshots
+    master->params.checkpointfreq = 0;        // No checkpoints
+    master->params.restart = NULL;            // New run
+    master->params.threads = 0;               // OMP_NUM_THREADS or one thread per core
+    master->params.profile = 0;               // No per-phase timing
+    master->params.reorder = 0;               // Process grid of MPI_Dims_create in rank order
+    master->params.bench = 0;                 // Single run, no benchmark trials
+    master->params.ensemble = 0;              // A single landscape
+    master->params.seedstep = 1;              // Consecutive seeds for the replicas
+    master->params.rhostep = 0.0;             // The same density for every replica
+    master->params.benchfile = "bench.csv";   // Benchmark results file
 
     // Determine the version based on the number of processes
     if (master->comm.size > 1) {
@@ -43,7 +107,294 @@ int read_parameters(master_str *master, int argc, char **argv) {
             master->params.landscape = atoi(argv[++i]);  // Set landscape size
         } else if (strcmp(argv[i], "-maxstep") == 0 && i + 1 < argc) {
             master->params.maxstep = atoi(argv[++i]);  // Set maximum steps
+        } else if (strcmp(argv[i], "-rule") == 0 && i + 1 < argc) {
+            i++;
+            if (parse_rule(argv[i], &master->params.rule)) {
+                if (master->comm.rank == 0) {
+                    printf("Error: malformed rule '%s', list the neighbourhood sums of live cells as in 2,4,5\n", argv[i]);
+                }
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-neighbourhood") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "vonneumann") == 0) {
+                master->params.rule.neighbourhood = von_neumann;
+            } else if (strcmp(argv[i], "moore") == 0) {
+                master->params.rule.neighbourhood = moore;  // Diagonal neighbours included
+            } else {
+                if (master->comm.rank == 0) {
+                    printf("Error: unknown neighbourhood '%s', use vonneumann or moore\n", argv[i]);
+                }
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-engine") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "fused") == 0) {
+                master->params.engine = fused_engine;  // Single pass over two swapped grids
+            } else if (strcmp(argv[i], "int") == 0) {
+                master->params.engine = int_engine;  // Separate neighbour count and update passes
+            } else if (strcmp(argv[i], "temporal") == 0) {
+                master->params.engine = temporal_engine;  // Several steps per sweep over deep halos
+            } else if (strcmp(argv[i], "hash") == 0) {
+                master->params.engine = hash_engine;  // Memoised quadtree jumping between print steps
+            } else if (strcmp(argv[i], "bit") == 0) {
+                master->params.engine = bit_engine;  // 64 cells per packed word
+            } else if (strcmp(argv[i], "simd") == 0) {
+#ifdef SIMD
+                master->params.engine = simd_engine;  // One byte per cell, vectorised
+#else
+                if (master->comm.rank == 0) {
+                    printf("Error: the simd engine is not compiled in, rebuild with DEFINE=-DSIMD\n");
+                }
+                return 1;
+#endif
+            } else {
+                if (master->comm.rank == 0) {
+                    printf("Error: unknown engine '%s', use fused, int, bit, simd, temporal or hash\n", argv[i]);
+                }
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-overlap") == 0) {
+            master->params.overlap = 1;  // Compute the interior while the halos are in flight
+        } else if (strcmp(argv[i], "-exchange") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "persistent") == 0) {
+                master->params.exchange = persistent_exchange;
+            } else if (strcmp(argv[i], "message") == 0) {
+                master->params.exchange = message_exchange;  // Post new halo requests every step
+            } else if (strcmp(argv[i], "neighbour") == 0) {
+                master->params.exchange = neighbour_exchange;  // One neighbourhood collective every step
+            } else if (strcmp(argv[i], "shared") == 0) {
+                master->params.exchange = shared_exchange;  // Read the halos of the neighbours on the node from shared memory
+            } else if (strcmp(argv[i], "rma") == 0) {
+                master->params.exchange = rma_exchange;  // Put the edges into the halos of the neighbours
+            } else {
+                if (master->comm.rank == 0) {
+                    printf("Error: unknown halo exchange '%s', use persistent, message, neighbour, shared or rma\n", argv[i]);
+                }
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-active") == 0) {
+            master->params.active = 1;  // Skip blocks that cannot have changed
+        } else if (strcmp(argv[i], "-halo") == 0 && i + 1 < argc) {
+            master->params.halo = atoi(argv[++i]);  // Set halo depth
+        } else if (strcmp(argv[i], "-init") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "uni") == 0) {
+                master->params.init = uni_init;
+            } else if (strcmp(argv[i], "counter") == 0) {
+                master->params.init = counter_init;  // Every rank generates its own tile
+            } else {
+                if (master->comm.rank == 0) {
+                    printf("Error: unknown initialisation '%s', use uni or counter\n", argv[i]);
+                }
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-snapfreq") == 0 && i + 1 < argc) {
+            master->params.snapfreq = atoi(argv[++i]);  // Set snapshot frequency
+        } else if (strcmp(argv[i], "-checkpoint") == 0 && i + 1 < argc) {
+            master->params.checkpointfreq = atoi(argv[++i]);  // Set checkpoint frequency
+        } else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc) {
+            master->params.threads = atoi(argv[++i]);  // Set threads per process
+        } else if (strcmp(argv[i], "-profile") == 0) {
+            master->params.profile = 1;  // Time the phases of the steps on every rank
+        } else if (strcmp(argv[i], "-reorder") == 0) {
+            master->params.reorder = 1;  // Choose the process grid and place the ranks by node
+        } else if (strcmp(argv[i], "-bench") == 0 && i + 1 < argc) {
+            master->params.bench = atoi(argv[++i]);  // Set benchmark trials
+        } else if (strcmp(argv[i], "-benchfile") == 0 && i + 1 < argc) {
+            master->params.benchfile = argv[++i];  // Set benchmark results file
+        } else if (strcmp(argv[i], "-ensemble") == 0 && i + 1 < argc) {
+            master->params.ensemble = atoi(argv[++i]);  // Set replicas
+        } else if (strcmp(argv[i], "-seedstep") == 0 && i + 1 < argc) {
+            master->params.seedstep = atoi(argv[++i]);  // Set seed increment between replicas
+        } else if (strcmp(argv[i], "-rhostep") == 0 && i + 1 < argc) {
+            master->params.rhostep = atof(argv[++i]);  // Set density increment between replicas
+        } else if (strcmp(argv[i], "-restart") == 0 && i + 1 < argc) {
+            master->params.restart = argv[++i];  // Resume from a checkpoint file
+        } else if (strcmp(argv[i], "-pbm") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "binary") == 0) {
+                master->params.pbm = pbm_binary;
+            } else if (strcmp(argv[i], "ascii") == 0) {
+                master->params.pbm = pbm_ascii;  // P1 image written by rank 0
+            } else {
+                if (master->comm.rank == 0) {
+                    printf("Error: unknown image format '%s', use binary or ascii\n", argv[i]);
+                }
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-isa") == 0 && i + 1 < argc) {
+            i++;
+            if (strcmp(argv[i], "auto") == 0) {
+                master->params.isa = isa_auto;
+            } else if (strcmp(argv[i], "scalar") == 0) {
+                master->params.isa = isa_scalar;
+            } else if (strcmp(argv[i], "sse2") == 0) {
+                master->params.isa = isa_sse2;
+            } else if (strcmp(argv[i], "avx2") == 0) {
+                master->params.isa = isa_avx2;
+            } else if (strcmp(argv[i], "avx512") == 0) {
+                master->params.isa = isa_avx512;
+            } else {
+                if (master->comm.rank == 0) {
+                    printf("Error: unknown instruction set '%s', use auto, scalar, sse2, avx2 or avx512\n", argv[i]);
+                }
+                return 1;
+            }
+        }
+    }
+
+    // Threads are only available in OpenMP builds
+#ifdef _OPENMP
+    if (master->params.threads > 0) {
+        omp_set_num_threads(master->params.threads);
+    }
+    master->params.threads = omp_get_max_threads();
+#else
+    if (master->params.threads > 1) {
+        if (master->comm.rank == 0) {
+            printf("Error: threads are not compiled in, rebuild with DEFINE=-DOPENMP\n");
+        }
+        return 1;
+    }
+    master->params.threads = 1;
+#endif
+
+    // Sums run up to the size of the neighbourhood
+    if (compile_rule(&master->params.rule)) {
+        if (master->comm.rank == 0) {
+            printf("Error: rule sums must not exceed %d on the %s neighbourhood\n",
+                   master->params.rule.neighbourhood == moore ? 9 : 5, master->params.rule.neighbourhood == moore ? "Moore" : "von Neumann");
+        }
+        return 1;
+    }
+
+    // The temporal engine advances as many steps per sweep as its halos are deep
+    if (master->params.engine == temporal_engine && master->params.halo == 1) {
+        master->params.halo = TEMPORAL_DEPTH;
+    }
+
+    // Deep halos are advanced with the fused kernel only
+    if (master->params.halo < 1 || (master->params.halo > 1 && master->params.engine != fused_engine && master->params.engine != temporal_engine)) {
+        if (master->comm.rank == 0) {
+            printf("Error: halo depth must be at least 1, and depths above 1 require the fused or temporal engine\n");
+        }
+        return 1;
+    }
+
+    // The diagonal neighbours are read from the corner halos, which only the deep halo exchange fills
+    if (master->params.rule.neighbourhood == moore && ((master->params.engine != fused_engine && master->params.engine != temporal_engine) ||
+            master->params.overlap || master->params.active || master->params.profile || master->params.snapfreq > 0 || master->params.checkpointfreq > 0)) {
+        if (master->comm.rank == 0) {
+            printf("Error: the Moore neighbourhood requires the fused or temporal engine, without -overlap, -active, -profile, snapshots or checkpoints\n");
+        }
+        return 1;
+    }
+
+    // The quadtree holds the whole landscape, with the seam of the periodic rows between its first
+    // and last rows, and its cells see their four orthogonal neighbours
+    if (master->params.engine == hash_engine && (master->comm.size > 1 || master->params.rule.neighbourhood == moore ||
+            master->params.landscape < 2)) {
+        if (master->comm.rank == 0) {
+            printf("Error: the hash engine requires a single process, the von Neumann neighbourhood and a landscape of at least 2\n");
+        }
+        return 1;
+    }
+
+    // The hash engine sees the live cells only at the end of each jump, so a landscape that leaves the
+    // termination thresholds and comes back within a jump would run on. Other rules than the built-in
+    // one are only advanced with it when the thresholds are off, in a benchmark
+    rule_str builtin;
+    parse_rule(RULE, &builtin);
+    if (master->params.engine == hash_engine && master->params.bench == 0 &&
+            memcmp(builtin.alive, master->params.rule.alive, sizeof(builtin.alive)) != 0) {
+        if (master->comm.rank == 0) {
+            printf("Error: the hash engine checks the termination thresholds only between jumps, so it takes other rules than %s only with -bench\n", RULE);
+        }
+        return 1;
+    }
+
+    // The interior and the edges are split in the halo exchange loop of par_process
+    if (master->params.overlap && (master->comm.size == 1 || master->params.halo > 1 ||
+            (master->params.engine != fused_engine && master->params.engine != int_engine))) {
+        if (master->comm.rank == 0) {
+            printf("Error: -overlap requires more than one process and the fused or int engine with halo depth 1\n");
+        }
+        return 1;
+    }
+
+    // Change tracking relies on the two grids of the fused engine holding the last two generations
+    if (master->params.active && (master->params.engine != fused_engine || master->params.halo > 1 || master->params.overlap)) {
+        if (master->comm.rank == 0) {
+            printf("Error: -active requires the fused engine with halo depth 1 and no -overlap\n");
+        }
+        return 1;
+    }
+
+    // The neighbours on the node read the edges of the grid the fused engine is not writing, and the
+    // halos of -active are messages of varying length
+    if (master->params.exchange == shared_exchange && (master->params.engine != fused_engine || master->params.halo > 1 ||
+            master->params.rule.neighbourhood == moore || master->params.active)) {
+        if (master->comm.rank == 0) {
+            printf("Error: the shared halo exchange requires the fused engine with halo depth 1, the von Neumann neighbourhood and no -active\n");
+        }
+        return 1;
+    }
+
+    // The windows are on the grids of par_process, whose halos -active receives as messages of varying length
+    if (master->params.exchange == rma_exchange && ((master->params.engine != fused_engine && master->params.engine != int_engine) ||
+            master->params.halo > 1 || master->params.rule.neighbourhood == moore || master->params.active)) {
+        if (master->comm.rank == 0) {
+            printf("Error: the RMA halo exchange requires the fused or int engine with halo depth 1, the von Neumann neighbourhood and no -active\n");
+        }
+        return 1;
+    }
+
+    // The phases are those of the halo exchange loop of par_process
+    if (master->params.profile && (master->comm.size == 1 || master->params.halo > 1 ||
+            (master->params.engine != fused_engine && master->params.engine != int_engine))) {
+        if (master->comm.rank == 0) {
+            printf("Error: -profile requires more than one process and the fused or int engine with halo depth 1\n");
+        }
+        return 1;
+    }
+
+    // Every trial of a benchmark would rewrite the same snapshots and checkpoints
+    if (master->params.bench < 0 || (master->params.bench > 0 && (master->params.snapfreq > 0 || master->params.checkpointfreq > 0))) {
+        if (master->comm.rank == 0) {
+            printf("Error: benchmark trials must not be negative, and benchmarks take no snapshots or checkpoints\n");
+        }
+        return 1;
+    }
+
+    // The replicas of an ensemble are the bits of the words of one whole landscape in a single process
+    if (master->params.ensemble < 0 || master->params.ensemble > MAXREPLICAS || (master->params.ensemble > 0 &&
+            (master->comm.size > 1 || master->params.rule.neighbourhood == moore || master->params.overlap || master->params.active ||
+             master->params.bench > 0 || master->params.snapfreq > 0 || master->params.checkpointfreq > 0 || master->params.restart != NULL))) {
+        if (master->comm.rank == 0) {
+            printf("Error: an ensemble has 0 to %d replicas and requires a single process and the von Neumann neighbourhood, "
+                   "without -overlap, -active, -bench, snapshots, checkpoints or -restart\n", MAXREPLICAS);
+        }
+        return 1;
+    }
+
+    // Snapshots are taken from the int grid of the fused and int engines
+    if (master->params.snapfreq < 0 || (master->params.snapfreq > 0 && (master->params.halo > 1 ||
+            (master->params.engine != fused_engine && master->params.engine != int_engine)))) {
+        if (master->comm.rank == 0) {
+            printf("Error: snapshot frequency must not be negative, and snapshots require the fused or int engine with halo depth 1\n");
+        }
+        return 1;
+    }
+
+    // Checkpoints are taken from the int grid of the fused and int engines
+    if (master->params.checkpointfreq < 0 || (master->params.checkpointfreq > 0 && (master->params.halo > 1 ||
+            (master->params.engine != fused_engine && master->params.engine != int_engine)))) {
+        if (master->comm.rank == 0) {
+            printf("Error: checkpoint frequency must not be negative, and checkpoints require the fused or int engine with halo depth 1\n");
         }
+        return 1;
     }
 
     return 0;  // Return 0 to indicate successful completion
@@ -1,12 +1,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/resource.h>
 #include "structs.h"
 #include "arralloc.h"
+#include "bitlib.h"
 
 
 #define HALO 1
 
+// Bytes of grid storage allocated by the functions below.
+static size_t allocated_bytes = 0;
 
 // Handle memory allocation failure.
 void handle_allocation_failure() {
@@ -20,31 +24,169 @@ int** allocate_2d_array(int rows, int cols) {
     if (array == NULL) {
         handle_allocation_failure();
     }
+    allocated_bytes += (size_t) rows * cols * sizeof(int) + rows * sizeof(int*);
     return array;
 }
 
 
+// Zero a padded grid with the row distribution of the threaded row loops, so that with OpenMP each
+// row is first touched, and its pages placed on the NUMA node, by the thread that will update it.
+static void first_touch_rows(int **array, int rows, int cols) {
+    memset(array[0], 0, (cols + (HALO*2)) * sizeof(int));
+    #pragma omp parallel for schedule(static)
+    for (int i = 1; i <= rows; i++) {
+        memset(array[i], 0, (cols + (HALO*2)) * sizeof(int));
+    }
+    memset(array[rows + 1], 0, (cols + (HALO*2)) * sizeof(int));
+}
+
 int** create_cell_array(master_str *master) {
-    return allocate_2d_array(master->dimensions.rows + (HALO*2), master->dimensions.cols + (HALO*2));
+    int **array = allocate_2d_array(master->dimensions.rows + (HALO*2), master->dimensions.cols + (HALO*2));
+    first_touch_rows(array, master->dimensions.rows, master->dimensions.cols);
+    return array;
 }
 
 int** create_neighbours_array(master_str *master) {
-    return allocate_2d_array(master->dimensions.rows + (HALO*2), master->dimensions.cols + (HALO*2));
+    int **array = allocate_2d_array(master->dimensions.rows + (HALO*2), master->dimensions.cols + (HALO*2));
+    first_touch_rows(array, master->dimensions.rows, master->dimensions.cols);
+    return array;
 }
 
 int** create_local_cell_array(master_str *master) {
     return allocate_2d_array(master->dimensions.rows, master->dimensions.cols);
 }
 
+// Only the root holds the whole landscape; the other processes only ever hold their tile.
 int** create_global_array(master_str *master) {
+    if (master->params.version == par2D && master->comm.rank != 0) {
+        return NULL;
+    }
     return allocate_2d_array(master->params.landscape, master->params.landscape);
 }
 
-int** create_reduction_array(master_str *master) {
-    return allocate_2d_array(master->params.landscape, master->params.landscape);
+uint64_t** create_packed_cell_array(master_str *master) {
+    uint64_t **array = (uint64_t**) arralloc(sizeof(uint64_t), 2, master->dimensions.rows + (HALO*2), PACKED_WORDS(master->dimensions.cols));
+    if (array == NULL) {
+        handle_allocation_failure();
+    }
+    allocated_bytes += (size_t) (master->dimensions.rows + (HALO*2)) * PACKED_WORDS(master->dimensions.cols) * sizeof(uint64_t);
+    return array;
+}
+
+// Allocate a padded grid of one word per cell, bit k of which is the cell of replica k of an
+// ensemble, zeroed so that the halo columns stay empty.
+uint64_t** create_ensemble_cell_array(master_str *master) {
+    int rows = master->dimensions.rows + (HALO*2);
+    int cols = master->dimensions.cols + (HALO*2);
+    uint64_t **array = (uint64_t**) arralloc(sizeof(uint64_t), 2, rows, cols);
+    if (array == NULL) {
+        handle_allocation_failure();
+    }
+    for (int i = 0; i < rows; i++) {
+        memset(array[i], 0, cols * sizeof(uint64_t));
+    }
+    allocated_bytes += (size_t) rows * cols * sizeof(uint64_t);
+    return array;
+}
+
+uint64_t* create_packed_buffer(int nwords) {
+    uint64_t *buffer = (uint64_t*) calloc(nwords, sizeof(uint64_t));
+    if (buffer == NULL) {
+        handle_allocation_failure();
+    }
+    return buffer;
+}
+
+// Allocate a padded byte-per-cell grid as row pointers into one contiguous, zeroed block,
+// so that it can be freed with a single call like the arralloc arrays.
+uint8_t** create_byte_cell_array(master_str *master) {
+    int rows = master->dimensions.rows + (HALO*2);
+    int cols = master->dimensions.cols + (HALO*2);
+    uint8_t **array = (uint8_t**) malloc(rows * sizeof(uint8_t*) + (size_t) rows * cols);
+    if (array == NULL) {
+        handle_allocation_failure();
+    }
+    uint8_t *data = (uint8_t*) (array + rows);
+    memset(data, 0, (size_t) rows * cols);
+    allocated_bytes += (size_t) rows * cols;
+    for (int i = 0; i < rows; i++) {
+        array[i] = data + (size_t) i * cols;
+    }
+    return array;
+}
+
+// Allocate a grid with depth halo rows and columns on every side, zeroed, as row pointers into one
+// block. The pointers are offset so that, as for the other grids, [1][1] is the first interior cell
+// and the halos span indices 1-depth..0 and rows+1..rows+depth.
+int** create_deep_cell_array(master_str *master, int depth) {
+    int rows = master->dimensions.rows + 2 * depth;
+    int cols = master->dimensions.cols + 2 * depth;
+    int **array = (int**) malloc(rows * sizeof(int*) + (size_t) rows * cols * sizeof(int));
+    if (array == NULL) {
+        handle_allocation_failure();
+    }
+    int *data = (int*) (array + rows);
+    memset(data, 0, (size_t) rows * cols * sizeof(int));
+    allocated_bytes += (size_t) rows * cols * sizeof(int);
+    for (int i = 0; i < rows; i++) {
+        array[i] = data + (size_t) i * cols + (depth - 1);
+    }
+    return array + (depth - 1);
+}
+
+// Free a grid allocated by create_deep_cell_array.
+void free_deep_cell_array(int **array, int depth) {
+    free(array - (depth - 1));
+}
+
+// Allocate a zeroed row spanning the columns 1-depth..cols+depth of a deep halo grid.
+int* create_deep_row(master_str *master, int depth) {
+    int *row = (int*) calloc(master->dimensions.cols + 2 * depth, sizeof(int));
+    if (row == NULL) {
+        handle_allocation_failure();
+    }
+    return row + (depth - 1);
 }
 
-void deallocate_arrays(void *cell_grid, void *neighbors_grid, void *global_cell_grid, void *local_cell_grid, void *reduction_cell_grid) {
+// Free a row allocated by create_deep_row.
+void free_deep_row(int *row, int depth) {
+    free(row - (depth - 1));
+}
+
+// Swap two grids so the freshly computed generation becomes the current one without copying.
+void swap_arrays(int ***cell_grid, int ***next_grid) {
+    int **tmp = *cell_grid;
+    *cell_grid = *next_grid;
+    *next_grid = tmp;
+}
+
+// Swap two packed grids so the freshly computed generation becomes the current one without copying.
+void swap_packed_arrays(uint64_t ***packed_grid, uint64_t ***next_grid) {
+    uint64_t **tmp = *packed_grid;
+    *packed_grid = *next_grid;
+    *next_grid = tmp;
+}
+
+// Swap two byte grids so the freshly computed generation becomes the current one without copying.
+void swap_byte_arrays(uint8_t ***byte_grid, uint8_t ***next_grid) {
+    uint8_t **tmp = *byte_grid;
+    *byte_grid = *next_grid;
+    *next_grid = tmp;
+}
+
+// Return the grid storage allocated so far, in megabytes.
+double allocated_memory_mb(void) {
+    return allocated_bytes / (1024.0 * 1024.0);
+}
+
+// Return the peak resident memory of the process so far, in megabytes, including the MPI library.
+double peak_memory_mb(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;  // ru_maxrss is in kilobytes
+}
+
+void deallocate_arrays(void *cell_grid, void *neighbors_grid, void *global_cell_grid, void *local_cell_grid) {
     // Check each array pointer and free memory if it is not NULL.
     if (cell_grid) {
         free(cell_grid);
@@ -58,7 +200,4 @@ void deallocate_arrays(void *cell_grid, void *neighbors_grid, void *global_cell_
     if (local_cell_grid) {
         free(local_cell_grid);
     }
-    if (reduction_cell_grid) {
-        free(reduction_cell_grid);
-    }
 }
@@ -1,6 +1,7 @@
 #ifndef MEM_H
 #define MEM_H
 
+#include <stdint.h>
 #include "structs.h"  // Including necessary structures like master_str for context
 
 // Function declarations for memory management related to cellular automaton arrays:
@@ -14,14 +15,50 @@ int** create_neighbours_array(master_str *master);
 // Creates an array for managing smaller, often sub-processed cells
 int** create_local_cell_array(master_str *master);
 
-// Creates an array that encompasses all cells in the simulation, used for comprehensive processes
+// Creates an array that encompasses all cells in the simulation on the root, NULL on the other processes
 int** create_global_array(master_str *master);
 
-// Creates a temporary array used for intermediate calculations or storage
-int** create_reduction_array(master_str *master);
+// Creates a padded grid of bit-packed cells for the bit-packed engine
+uint64_t** create_packed_cell_array(master_str *master);
+
+// Allocates a zeroed padded grid of one word per cell holding the cells of up to 64 replicas
+uint64_t** create_ensemble_cell_array(master_str *master);
+
+// Creates a zeroed buffer of packed words used for masks and halo columns
+uint64_t* create_packed_buffer(int nwords);
+
+// Creates a padded grid with one byte per cell for the SIMD engine
+uint8_t** create_byte_cell_array(master_str *master);
+
+// Creates a grid with halos of the given depth, indexed like the other padded grids
+int** create_deep_cell_array(master_str *master, int depth);
+
+// Frees a grid created by create_deep_cell_array
+void free_deep_cell_array(int **array, int depth);
+
+// Creates a row spanning the halo columns of a deep halo grid
+int* create_deep_row(master_str *master, int depth);
+
+// Frees a row created by create_deep_row
+void free_deep_row(int *row, int depth);
+
+// Swaps the current and next cell grids to avoid copying data between generations
+void swap_arrays(int ***cell_grid, int ***next_grid);
+
+// Swaps the current and next packed grids to avoid copying data between generations
+void swap_packed_arrays(uint64_t ***packed_grid, uint64_t ***next_grid);
+
+// Swaps the current and next byte grids to avoid copying data between generations
+void swap_byte_arrays(uint8_t ***byte_grid, uint8_t ***next_grid);
+
+// Returns the grid storage allocated so far in megabytes
+double allocated_memory_mb(void);
+
+// Returns the peak resident memory of the process so far in megabytes
+double peak_memory_mb(void);
 
 // Deallocates all dynamic memory allocated for arrays used in the simulation
-void deallocate_arrays(void *cell, void *neigh, void *allcell, void *smallcell, void *tmpcell);
+void deallocate_arrays(void *cell, void *neigh, void *allcell, void *smallcell);
 
 // Allocates all dynamic memory allocated for arrays used in the simulation
 int** allocate_2d_array(int rows, int cols);
@@ -1,5 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include "mem.h"
 /*
  *	Global variables for rstart & uni
  */
@@ -140,6 +142,34 @@ void rinit(int ijkl)
 
 
 
+/*
+ *  Counter-based generator: the random number for a cell is a pure
+ *  function of (seed, global row, global column), obtained by passing
+ *  the key through the SplitMix64 finaliser. Any process can therefore
+ *  generate any part of the landscape without generating the rest, and
+ *  the landscape does not depend on the decomposition.
+ */
+
+static uint64_t splitmix64(uint64_t x)
+{
+	x += 0x9E3779B97F4A7C15ULL;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+	return x ^ (x >> 31);
+}
+
+double counter_uni(int seed, int row, int col)
+{
+	uint64_t key = splitmix64((uint64_t) (uint32_t) seed);
+
+	key = splitmix64(key ^ (uint64_t) (uint32_t) row);
+	key = splitmix64(key ^ ((uint64_t) (uint32_t) col << 32));
+
+	/* top 53 bits give a double uniformly distributed in [0, 1) */
+	return (double) (key >> 11) * (1.0 / 9007199254740992.0);
+}
+
+
 /*
  *  Function to write a percolation map in black and white Portable
  *  Bit Map (PBM) format.
@@ -221,4 +251,60 @@ void writecelldynamic(char *cellfile, int **cell, int l)
 
   fclose(fp);
   printf("writecelldynamic: file closed\n");
+}
+
+
+/*
+ *  Same as writecelldynamic but in the binary PBM format (P4), where
+ *  each row of the image is packed eight pixels to a byte, most
+ *  significant bit first, and padded to a whole byte.
+ */
+
+void writecellbinary(char *cellfile, int **cell, int l)
+{
+  FILE *fp;
+  unsigned char *line;
+
+  int i, j, rowbytes;
+
+  printf("writecellbinary: opening file <%s>\n", cellfile);
+
+  fp = fopen(cellfile, "wb");
+
+  printf("writecellbinary: writing data ...\n");
+
+  fprintf(fp, "P4\n");
+  fprintf(fp, "# Written by writecellbinary\n");
+  fprintf(fp, "%d %d\n", l, l) ;
+
+  rowbytes = (l + 7) / 8;
+  line = (unsigned char *) malloc(rowbytes);
+  if (line == NULL)
+    {
+      handle_allocation_failure();
+    }
+
+  /*
+   *  As in writecelldynamic, cell[0][0] is in the bottom-left-hand corner
+   */
+
+  for (j=l-1; j >= 0; j--)
+    {
+      for (i=0; i < rowbytes; i++) line[i] = 0;
+
+      for (i=0; i < l; i++)
+	{
+	  // 1 is black, so the dead cells set their bit
+	  if (cell[i][j] != 1) line[i/8] |= (unsigned char) (0x80 >> (i%8));
+	}
+
+      fwrite(line, 1, rowbytes, fp);
+    }
+
+  free(line);
+
+  printf("writecellbinary: ... done\n");
+
+  fclose(fp);
+  printf("writecellbinary: file closed\n");
 }
\ No newline at end of file
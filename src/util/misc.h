@@ -10,6 +10,14 @@
 //    l - the length of the array (assumed square for simplicity)
 void writecelldynamic(char *cellfile, int **cell, int l);
 
+// Writes the cell array to a specified file as a binary (P4) PBM image with the same
+// orientation as writecelldynamic
+// Parameters:
+//    cellfile - the file path where the cell data will be written
+//    cell - pointer to the 2D array of cells
+//    l - the length of the array (assumed square for simplicity)
+void writecellbinary(char *cellfile, int **cell, int l);
+
 // Seeds the random number generator with a specific integer
 // Parameter:
 //    ijkl - the seed value
@@ -18,4 +26,11 @@ void rinit(int ijkl);
 // Returns a uniformly distributed random number between 0.0 and 1.0
 float uni(void);
 
+// Returns a uniformly distributed random number between 0.0 and 1.0 that depends only on
+// the seed and the global position of the cell, so any process can generate any cell
+// Parameters:
+//    seed - the seed value
+//    row, col - the global coordinates of the cell
+double counter_uni(int seed, int row, int col);
+
 #endif // MISC_H
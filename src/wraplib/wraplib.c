@@ -7,6 +7,7 @@
 #include "wraplib.h"
 #include "serlib.h"
 #include "parlib.h"
+#include "mplib.h"
 #include "structs.h"
 
 // Initializes the communication channels based on the type of parallelization
@@ -19,6 +20,10 @@ status read_args(master_str *master, int argc, char **argv) {
     if (read_parameters(master, argc, argv) == 1) {
         return FAILED;
     }
+    // The process grid is rebuilt now that -reorder is known, before anything depends on it.
+    if (master->params.reorder) {
+        setup_node_aware_topology(&master->comm, &master->cart);
+    }
     return SUCCESS;
 }
 
@@ -32,9 +37,31 @@ void initialise_and_distribute(master_str *master, int **cell_grid, int **global
     }
 }
 
-// Processes cells based on the execution mode
-void process(master_str *master, int **cell_grid, int **neighbor_grid) {
-    if (master->params.version == par2D) {
+// Processes cells based on the execution mode and the selected engine
+void process(master_str *master, int ***cell_grid, int ***neighbor_grid) {
+    if (master->params.ensemble > 0) {
+        ser_ensemble_process(master, *cell_grid);
+    } else if (master->params.engine == bit_engine) {
+        if (master->params.version == par2D) {
+            par_bit_process(master, *cell_grid);
+        } else if (master->params.version == serial) {
+            ser_bit_process(master, *cell_grid);
+        }
+    } else if (master->params.engine == hash_engine) {
+        ser_hash_process(master, *cell_grid, *neighbor_grid);
+#ifdef SIMD
+    } else if (master->params.engine == simd_engine) {
+        if (master->params.version == par2D) {
+            par_simd_process(master, *cell_grid);
+        } else if (master->params.version == serial) {
+            ser_simd_process(master, *cell_grid);
+        }
+#endif
+    } else if (master->params.halo > 1 || master->params.rule.neighbourhood == moore) {
+        // A single process exchanges its deep halos with itself across the periodic rows. The Moore
+        // neighbourhood takes this path at any depth for the corner halos it fills.
+        par_deep_halo_process(master, *cell_grid);
+    } else if (master->params.version == par2D) {
         par_process(master, cell_grid, neighbor_grid);
     } else if (master->params.version == serial) {
         ser_process(master, cell_grid, neighbor_grid);
@@ -61,20 +88,29 @@ void stop_timing(master_str *master) {
 }
 
 // Gathers data from worker nodes and writes it to files or other outputs
-void gather_write_data(master_str *master, int **local_cell_grid, int **reduction_cell_grid, int **global_cell_grid, int **cell_grid) {
+void gather_write_data(master_str *master, int **local_cell_grid, int **global_cell_grid, int **cell_grid) {
     if (master->params.version == par2D) {
-        par_gather_write_data(master, local_cell_grid, reduction_cell_grid, global_cell_grid, cell_grid);
+        par_gather_write_data(master, local_cell_grid, global_cell_grid, cell_grid);
     }
     if (master->params.version == serial) {
-        ser_gather_write_data(master, local_cell_grid, reduction_cell_grid, global_cell_grid, cell_grid);
+        ser_gather_write_data(master, local_cell_grid, global_cell_grid, cell_grid);
     }
 }
 
 // Cleans up buffers and stops communication, preparing for shutdown
-void clean_buffers_stop_comm(master_str *master, int **cell_grid, int **neighbor_grid, int **global_cell_grid, int **local_cell_grid, int **reduction_cell_grid) {
+void clean_buffers_stop_comm(master_str *master, int **cell_grid, int **neighbor_grid, int **global_cell_grid, int **local_cell_grid) {
+    if (master->params.version == par2D) {
+        par_clean_buffers_stop_comm(master, cell_grid, neighbor_grid, global_cell_grid, local_cell_grid);
+    } else if (master->params.version == serial) {
+        ser_clean_buffers_stop_comm(master, cell_grid, neighbor_grid, global_cell_grid, local_cell_grid);
+    }
+}
+
+// Reports the memory held by each process after initialisation
+void report_memory(master_str *master) {
     if (master->params.version == par2D) {
-        par_clean_buffers_stop_comm(master, cell_grid, neighbor_grid, global_cell_grid, local_cell_grid, reduction_cell_grid);
+        par_report_memory(master);
     } else if (master->params.version == serial) {
-        ser_clean_buffers_stop_comm(master, cell_grid, neighbor_grid, global_cell_grid, local_cell_grid, reduction_cell_grid);
+        ser_report_memory(master);
     }
 }
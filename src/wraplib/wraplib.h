@@ -12,11 +12,15 @@ status read_args(master_str *master, int argc, char **argv);
 // Initializes and distributes the computational workload among available resources
 void initialise_and_distribute(master_str *master, int **cell_grid, int **global_cell_grid, int **local_cell_grid);
 
-// Executes the main processing logic based on the computation model (serial or parallel)
-void process(master_str *master, int **cell_grid, int **neighbor_grid);
+// Executes the main processing logic based on the computation model (serial or parallel);
+// the cell and neighbour grid pointers may be swapped by double-buffered engines
+void process(master_str *master, int ***cell_grid, int ***neighbor_grid);
 
 // Cleans up and deallocates memory buffers, stops communication channels
-void clean_buffers_stop_comm(master_str *master, int **cell_grid, int **neighbor_grid, int **global_cell_grid, int **local_cell_grid, int **reduction_cell_grid);
+void clean_buffers_stop_comm(master_str *master, int **cell_grid, int **neighbor_grid, int **global_cell_grid, int **local_cell_grid);
+
+// Reports the grid storage and peak resident memory held by each process
+void report_memory(master_str *master);
 
 // Starts timing for performance measurement, usually used for benchmarking
 void start_timing(master_str *master);
@@ -25,6 +29,6 @@ void start_timing(master_str *master);
 void stop_timing(master_str *master);
 
 // Gathers data from distributed systems and prepares it for output or storage
-void gather_write_data(master_str *master, int **local_cell_grid, int **reduction_cell_grid, int **global_cell_grid, int **cell_grid);
+void gather_write_data(master_str *master, int **local_cell_grid, int **global_cell_grid, int **cell_grid);
 
 #endif // __WRAPLIB_H__
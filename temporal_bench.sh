@@ -0,0 +1,39 @@
+#!/bin/bash
+# temporal_bench.sh
+# This script compares the steps per second of the fused engine, which sweeps the grid once per
+# step, with the temporally blocked engine, which advances each block of rows several steps while
+# it is in cache, for landscape sizes from 500 to 5000.
+# The automaton must be built with DEFINE=-DTIME so that it prints its loop time.
+
+OUTPUT_FILE="temporal_results.txt"
+SEED=42      # Fixed seed for all runs
+STEPS=200    # Steps per run
+NP=${NP:-1}  # Number of processes, 1 by default
+
+# Remove any existing output file.
+rm -f "$OUTPUT_FILE"
+
+# Write a minimal header.
+echo "Temporal blocking benchmark: $NP process(es), $STEPS steps, steps per second" > "$OUTPUT_FILE"
+echo "Start Time: $(date)" >> "$OUTPUT_FILE"
+echo "" >> "$OUTPUT_FILE"
+printf "%-10s %-12s %-12s %-8s\n" "Landscape" "fused" "temporal" "speedup" >> "$OUTPUT_FILE"
+
+# List of landscape sizes.
+landscapes=(500 1000 1500 2000 2500 3000 3500 4000 4500 5000)
+
+# Run one configuration and print its steps per second from the "Average Time" line.
+steps_per_second() {
+    mpirun -n "$NP" ./automaton "$SEED" -landscape "$1" -maxstep "$STEPS" -printfreq "$STEPS" $2 |
+        awk -v steps="$STEPS" '/Average Time/ { printf "%.1f", steps / $NF }'
+}
+
+for LAND in "${landscapes[@]}"; do
+    FUSED=$(steps_per_second "$LAND" "-engine fused")
+    TEMPORAL=$(steps_per_second "$LAND" "-engine temporal")
+    SPEEDUP=$(awk -v a="$FUSED" -v b="$TEMPORAL" 'BEGIN { printf "%.2f", b / a }')
+    printf "%-10s %-12s %-12s %-8s\n" "$LAND" "$FUSED" "$TEMPORAL" "$SPEEDUP" >> "$OUTPUT_FILE"
+done
+
+echo "" >> "$OUTPUT_FILE"
+echo "End Time: $(date)" >> "$OUTPUT_FILE"